@@ -30,15 +30,36 @@ duration given in ::Animation, then the animation will switch to the next frame.
 *******************************************************************************/
 void Animation::update()
 {
-    frame_timer++;
-    if (!loop && isOnLastFrame() && frame_timer >= frame_duration)
+    advance(1);
+}
+
+/***************************************************************************//**
+Works out how many whole frames fit into the time spent on the current frame
+plus \p cycles. A looping animation wraps around, and one that doesn't loop
+stops on its last frame.
+*******************************************************************************/
+void Animation::advance(int cycles)
+{
+    if (cycles <= 0)
+    {
+        return;
+    }
+
+    int elapsed = frame_timer + cycles;
+    int frames_passed = elapsed / frame_duration;
+    frame_timer = elapsed % frame_duration;
+
+    if (loop)
+    {
+        current_frame = (current_frame + frames_passed) % total_frames;
+    }
+    else if (current_frame + frames_passed >= total_frames - 1)
     {
-        frame_timer = 0;
+        current_frame = total_frames - 1;
     }
-    else if (frame_timer >= frame_duration)
+    else
     {
-        frame_timer = 0;
-        current_frame = (current_frame + 1) % total_frames;
+        current_frame += frames_passed;
     }
 }
 
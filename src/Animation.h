@@ -69,6 +69,10 @@ Returns true if the animation isn't looping, and is on the last frame.
 /***************************************************************************//**
 @fn void update()
 Should be called once per animation per game cycle.
+@fn void advance(int cycles)
+Moves the animation forward by \p cycles game cycles at once. This costs the
+same no matter how many cycles have passed, so an animation that wasn't
+updated while its object was off screen can catch up in one call.
 @fn void render(float x, float y, float x_scale = 1, float y_scale = 1) const
 Draws the current animation frame to the screen.
 @param x X coordinate of animation on screen.
@@ -77,6 +81,7 @@ Draws the current animation frame to the screen.
 @param y_scale Scale which the animation will be drawn along the y-axis.
 *******************************************************************************/
         void update();
+        void advance(int cycles);
         void render(float x, float y, float x_scale = 1, float y_scale = 1) const;
 
     private:
@@ -5,11 +5,41 @@
 #include "Keyboard.h"
 #include "TitleMenu.h"
 
+static const char *NAV_PATH = "./assets/nav/arena.nav";
+static const float ELF_SPEED = 5;
+
+// Folds size bytes at data into an FNV-1a hash
+static uint32_t hash_bytes(uint32_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Hashes the mesh's size and the position and size of each wall in it, so a
+// baked mesh from before any of them changed is rebuilt instead of loaded
+static uint32_t nav_key(const Barrier *const walls[], int count)
+{
+    const int size[3] = { WIDTH / 32, HEIGHT / 32, 32 };
+    uint32_t hash = hash_bytes(2166136261u, size, sizeof(size));
+    for (int i = 0; i < count; i++)
+    {
+        Vector3 pos = walls[i]->getPos(), dims = walls[i]->getDims();
+        const float wall[6] = { pos.x, pos.y, pos.z, dims.x, dims.y, dims.z };
+        hash = hash_bytes(hash, wall, sizeof(wall));
+    }
+    return hash;
+}
+
 Arena::Arena()
 {
     image = find_bitmap("main_menu");
     environment.setGravity(-0.82);
     path_timer = 0;
+    path_ticket = -1;
 
     Barrier *floor, *ceiling, *west_wall, *east_wall, *north_wall, *south_wall, *center_wall;
 
@@ -53,11 +83,22 @@ Arena::Arena()
     environment.pushBack(center_wall);
 
     // AI Mesh starts at the corner of the west and north walls, extends the whole floor past the north and south walls
-    // and has tiling of 32
-    mesh = new Mesh(0, 0, WIDTH / 32, HEIGHT / 32, 32);
-    mesh->insertObject(center_wall);
-    mesh->insertObject(north_wall);
-    mesh->insertObject(south_wall);
+    // and has tiling of 32. The walls never move, so the mesh is baked the first time and loaded after that. The
+    // file is keyed on the walls, so it is baked again whenever one of them changes
+    const Barrier *const nav_walls[] = { center_wall, north_wall, south_wall };
+    uint32_t key = nav_key(nav_walls, 3);
+    mesh = Mesh::load(NAV_PATH, key);
+    if (!mesh)
+    {
+        mesh = new Mesh(0, 0, WIDTH / 32, HEIGHT / 32, 32);
+        for (int i = 0; i < 3; i++)
+        {
+            mesh->insertObject(nav_walls[i]);
+        }
+        mesh->buildComponents();
+        mesh->buildClearance();
+        mesh->bake(NAV_PATH, key);
+    }
 
     hero = new Character;
     hero->setPos(Vector3(100, HEIGHT/2, hero->getDimsZ() / 2));
@@ -66,6 +107,9 @@ Arena::Arena()
     elf = new Character;
     elf->setPos(Vector3(WIDTH / 2 + 300, HEIGHT / 2, HEIGHT / 2));
     environment.pushBack(elf);
+
+    hero_agent = crowd.add(hero, hero->getDimsX() / 2, ELF_SPEED);
+    elf_agent = crowd.add(elf, elf->getDimsX() / 2, ELF_SPEED);
 }
 
 
@@ -94,43 +138,51 @@ void Arena::handleKey()
 
 void Arena::update()
 {
-    // Calc path from other character to ours so she can follow us
-    if (path_timer % 60 == 0)
+    // Calc path from other character to ours so she can follow us. The search
+    // runs in the background, and the elf keeps following her old path until
+    // the new one is ready.
+    path_queue.update(*mesh);
+    if (path_timer % 60 == 0 && path_ticket < 0)
     {
-        path = mesh->calcPath(elf->getPos(), hero->getPos());
+        PathOptions options(JUMP_POINT);
+        options.any_angle = true;
+        options.unreachable = NEAREST_REACHABLE;
+        options.radius = elf->getDimsX() / 2;
+        path_ticket = path_queue.submit(elf->getPos(), hero->getPos(), options);
         path_timer = 0;
     }
     path_timer++;
 
+    if (path_ticket >= 0 && path_queue.poll(path_ticket, path))
+    {
+        path_ticket = -1;
+    }
+
+    Vector3 preferred;
+    if (!path.empty() && (path.back() - elf->getPos()).mag() < 10)
+    {
+        path.pop_back();
+    }
     if (!path.empty())
     {
-        if ((path.back() - elf->getPos()).mag() < 10)
-        {
-            path.pop_back();
-        }
+        preferred = path.back() - elf->getPos();
+    }
 
-        if (!path.empty())
-        {
-            // Now figure out where to push the elf to go along that path
-            if (path.back().x < elf->getPosX())
-            {
-                elf->applyForce(Vector3(-elf->getMass(), 0, 0));
-            }
-            else
-            {
-                elf->applyForce(Vector3(elf->getMass(), 0, 0));
-            }
-
-            if (path.back().y < elf->getPosY())
-            {
-                elf->applyForce(Vector3(0, -elf->getMass(), 0));
-            }
-            else
-            {
-                elf->applyForce(Vector3(0, elf->getMass(), 0));
-            }
-        }
+    // The elf heads along her path but steps around the hero rather than
+    // bumping into them; the hero is assumed to keep moving as they are
+    crowd.setPreferredVelocity(elf_agent, preferred);
+    crowd.setPreferredVelocity(hero_agent, hero->getVel());
+    crowd.update();
+
+    // Push the elf towards the velocity the crowd chose for her, accelerating
+    // by at most 1 per game cycle
+    Vector3 steer = crowd.getVelocity(elf_agent) - elf->getVel();
+    steer.z = 0;
+    if (steer.mag() > 1)
+    {
+        steer = steer * (1 / steer.mag());
     }
+    elf->applyForce(steer * elf->getMass());
 
     environment.updateObjects();
     environment.detectCollisions();
@@ -3,7 +3,9 @@
 #include "Assets.h"
 #include "Environment.h"
 #include "Character.h"
+#include "Crowd.h"
 #include "Mesh.h"
+#include "PathQueue.h"
 #include <vector>
 
 class Arena : public State
@@ -21,6 +23,9 @@ class Arena : public State
         Character *hero, *elf;
         Environment environment;
         Mesh *mesh;
+        PathQueue path_queue;
+        Crowd crowd;
+        int hero_agent, elf_agent;
         std::vector<Vector3> path;
-        int path_timer;
+        int path_timer, path_ticket;
 };
\ No newline at end of file
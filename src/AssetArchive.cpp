@@ -0,0 +1,163 @@
+#include "AssetArchive.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char AssetArchive::MAGIC[4] = { 'B', 'P', 'A', 'K' };
+
+AssetArchive::AssetArchive()
+{
+    data = NULL;
+    data_size = 0;
+    entries = NULL;
+    names = NULL;
+    count = 0;
+}
+
+AssetArchive::~AssetArchive()
+{
+    close();
+}
+
+/*******************************************************************************
+Checks everything find relies on up front, so lookups can trust the index.
+*******************************************************************************/
+bool AssetArchive::open(const char *path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    void *mapping = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(Header))
+    {
+        mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    const char *file = (const char *)mapping;
+    size_t file_size = info.st_size;
+    Header header;
+    memcpy(&header, file, sizeof(header));
+
+    size_t index_end = sizeof(Header) + (size_t)header.count * sizeof(Entry);
+    bool valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == FORMAT_VERSION
+                 && index_end <= file_size && header.names_size <= file_size - index_end;
+
+    const Entry *index = (const Entry *)(file + sizeof(Header));
+    for (uint32_t i = 0; valid && i < header.count; i++)
+    {
+        valid = (uint64_t)index[i].name_offset + index[i].name_length <= header.names_size
+                && index[i].offset <= file_size && index[i].size <= file_size - index[i].offset;
+    }
+
+    if (!valid)
+    {
+        munmap(mapping, file_size);
+        return false;
+    }
+
+    data = file;
+    data_size = file_size;
+    entries = index;
+    names = file + index_end;
+    count = header.count;
+    return true;
+}
+
+void AssetArchive::close()
+{
+    if (data)
+    {
+        munmap((void *)data, data_size);
+    }
+
+    data = NULL;
+    data_size = 0;
+    entries = NULL;
+    names = NULL;
+    count = 0;
+}
+
+/*******************************************************************************
+Binary search over the index, comparing names byte by byte with the shorter
+name first on a tie, which is the order assetpack sorts them in.
+*******************************************************************************/
+const AssetArchive::Entry *AssetArchive::lookup(const std::string &name) const
+{
+    uint32_t low = 0, high = count;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        const Entry &entry = entries[middle];
+        size_t shorter = std::min<size_t>(entry.name_length, name.size());
+        int order = memcmp(names + entry.name_offset, name.data(), shorter);
+        if (order == 0)
+        {
+            order = entry.name_length < name.size() ? -1 : entry.name_length > name.size();
+        }
+
+        if (order < 0)
+        {
+            low = middle + 1;
+        }
+        else if (order > 0)
+        {
+            high = middle;
+        }
+        else
+        {
+            return &entry;
+        }
+    }
+
+    return NULL;
+}
+
+bool AssetArchive::find(const std::string &name, const char *&contents, size_t &size) const
+{
+    const Entry *entry = lookup(name);
+    if (!entry)
+    {
+        return false;
+    }
+
+    contents = data + entry->offset;
+    size = entry->size;
+    return checksum(contents, size) == entry->checksum;
+}
+
+bool AssetArchive::peek(const std::string &name, const char *&contents, size_t &size) const
+{
+    const Entry *entry = lookup(name);
+    if (!entry)
+    {
+        return false;
+    }
+
+    contents = data + entry->offset;
+    size = entry->size;
+    return true;
+}
+
+uint32_t AssetArchive::checksum(const char *contents, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ (unsigned char)contents[i]) * 16777619u;
+    }
+    return hash;
+}
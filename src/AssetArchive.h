@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/***************************************************************************//**
+An AssetArchive is a single file holding every asset of the game, so starting
+up maps one file instead of opening, reading and closing hundreds.\n
+The file starts with a header, followed by an index entry for every asset
+sorted by name, the names themselves, and then the raw file contents, each
+starting on a 16 byte boundary. An asset's name is its path relative to the
+directory that was packed, with forward slashes, such as
+"bitmaps/main_menu.png". Each entry holds a checksum of the contents, so a
+damaged archive is noticed before a loader is handed garbage.\n
+The archive is mapped read-only and looked up with a binary search over the
+index; nothing is copied. Archives are written by the assetpack tool:
+\verbatim
+./assetpack assets assets/assets.pak
+\endverbatim
+*******************************************************************************/
+class AssetArchive
+{
+    public:
+        AssetArchive();
+        ~AssetArchive();
+
+/***************************************************************************//**
+@fn bool open(const char *path)
+Maps the archive at path, closing any archive open before. Returns false if it
+is missing, was written by another version, or its index points outside the
+file.
+@fn void close()
+Unmaps the archive. Anything found in it must no longer be in use.
+@fn bool isOpen() const
+Returns true while an archive is mapped.
+*******************************************************************************/
+        bool open(const char *path);
+        void close();
+        bool isOpen() const { return data != NULL; }
+
+/***************************************************************************//**
+@fn bool find(const std::string &name, const char *&contents, size_t &size) const
+Points contents at the asset called name and sets size to its length. Returns
+false if the archive has no such asset, or its checksum doesn't match. The
+contents stay valid until the archive is closed. Safe to call from several
+threads.
+@fn bool peek(const std::string &name, const char *&contents, size_t &size) const
+Same as find, without checking the checksum, for when only the first few bytes
+will be read.
+*******************************************************************************/
+        bool find(const std::string &name, const char *&contents, size_t &size) const;
+        bool peek(const std::string &name, const char *&contents, size_t &size) const;
+
+/***************************************************************************//**
+@fn static uint32_t checksum(const char *contents, size_t size)
+The checksum stored for each asset: 32 bit FNV-1a over its contents.
+*******************************************************************************/
+        static uint32_t checksum(const char *contents, size_t size);
+
+/***************************************************************************//**
+@var MAGIC
+The first four bytes of every archive.
+@var FORMAT_VERSION
+Format version written by assetpack; archives of any other version are
+rejected.
+*******************************************************************************/
+        static const char MAGIC[4];
+        static const uint32_t FORMAT_VERSION = 1;
+
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint32_t count;      // Number of entries
+            uint32_t names_size; // Bytes of names after the entries
+        };
+
+        struct Entry {
+            uint32_t name_offset; // From the start of the names
+            uint32_t name_length;
+            uint64_t offset;      // From the start of the file
+            uint64_t size;
+            uint32_t checksum;
+            uint32_t padding;
+        };
+
+    private:
+        AssetArchive(const AssetArchive &);
+        AssetArchive &operator=(const AssetArchive &);
+
+        const Entry *lookup(const std::string &name) const;
+
+        const char *data;
+        size_t data_size;
+        const Entry *entries;
+        const char *names;
+        uint32_t count;
+};
@@ -0,0 +1,76 @@
+#include "AssetCache.h"
+using std::shared_ptr;
+using std::string;
+
+AssetCache::AssetCache(size_t budget)
+{
+    this->budget = budget;
+    bytes = 0;
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+}
+
+shared_ptr<void> AssetCache::find(const string &key)
+{
+    auto found = index.find(key);
+    if (found == index.end())
+    {
+        misses++;
+        return shared_ptr<void>();
+    }
+
+    entries.splice(entries.begin(), entries, found->second);
+    hits++;
+    return found->second->asset;
+}
+
+void AssetCache::insert(const string &key, const shared_ptr<void> &asset, size_t asset_bytes)
+{
+    auto found = index.find(key);
+    if (found != index.end())
+    {
+        bytes -= found->second->bytes;
+        entries.erase(found->second);
+        index.erase(found);
+    }
+
+    if (!asset || asset_bytes > budget)
+    {
+        return;
+    }
+
+    Entry entry = { key, asset, asset_bytes };
+    entries.push_front(entry);
+    index[key] = entries.begin();
+    bytes += asset_bytes;
+
+    while (bytes > budget)
+    {
+        evictBack();
+    }
+}
+
+void AssetCache::setBudget(size_t budget)
+{
+    this->budget = budget;
+    while (bytes > budget)
+    {
+        evictBack();
+    }
+}
+
+void AssetCache::clear()
+{
+    index.clear();
+    entries.clear();
+    bytes = 0;
+}
+
+void AssetCache::evictBack()
+{
+    bytes -= entries.back().bytes;
+    index.erase(entries.back().key);
+    entries.pop_back();
+    evictions++;
+}
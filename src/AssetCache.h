@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/***************************************************************************//**
+AssetCache keeps recently used assets in memory after the game lets go of
+them, so an asset that comes and goes, such as a boss theme, isn't decoded
+again each time it returns. Each asset is stored with an estimate of the bytes
+it occupies, and the least recently used assets are dropped once their total
+exceeds the budget.\n
+Assets are held as std::shared_ptr<void>, which keeps the deleter of whatever
+typed pointer it was made from, so bitmaps, fonts and samples share one budget.
+Keys are chosen by the caller and must tell the asset types apart.
+*******************************************************************************/
+class AssetCache
+{
+    public:
+/***************************************************************************//**
+@fn AssetCache(size_t budget)
+Creates a cache holding at most budget bytes of assets. A budget of 0 disables
+it.
+*******************************************************************************/
+        AssetCache(size_t budget = 64 << 20);
+
+/***************************************************************************//**
+@fn std::shared_ptr<void> find(const std::string &key)
+Returns the asset stored under key and marks it most recently used, or NULL if
+there is none.
+@fn bool contains(const std::string &key) const
+Returns true if an asset is stored under key, without counting a lookup or
+touching its place in the list.
+@fn void insert(const std::string &key, const std::shared_ptr<void> &asset, size_t bytes)
+Stores asset under key as the most recently used, replacing whatever was there,
+and evicts the least recently used assets until the cache is within budget.
+An asset larger than the whole budget isn't stored.
+*******************************************************************************/
+        std::shared_ptr<void> find(const std::string &key);
+        bool contains(const std::string &key) const { return index.count(key) != 0; }
+        void insert(const std::string &key, const std::shared_ptr<void> &asset, size_t bytes);
+
+/***************************************************************************//**
+@fn void setBudget(size_t budget)
+Changes the number of bytes the cache may hold, evicting the least recently
+used assets if it shrinks.
+@fn void clear()
+Drops every asset. Counters are kept.
+*******************************************************************************/
+        void setBudget(size_t budget);
+        void clear();
+
+/***************************************************************************//**
+@fn size_t size() const
+Returns the number of assets in the cache.
+@fn size_t getBudget() const
+Returns the number of bytes the cache may hold.
+@fn size_t getBytes() const
+Returns the estimated bytes held by the cached assets.
+@fn size_t getHits() const
+Returns the number of lookups that found an asset.
+@fn size_t getMisses() const
+Returns the number of lookups that found nothing.
+@fn size_t getEvictions() const
+Returns the number of assets dropped to stay within budget.
+*******************************************************************************/
+        size_t size() const { return entries.size(); }
+        size_t getBudget() const { return budget; }
+        size_t getBytes() const { return bytes; }
+        size_t getHits() const { return hits; }
+        size_t getMisses() const { return misses; }
+        size_t getEvictions() const { return evictions; }
+
+    private:
+        AssetCache(const AssetCache &);
+        AssetCache &operator=(const AssetCache &);
+
+        struct Entry {
+            std::string key;
+            std::shared_ptr<void> asset;
+            size_t bytes;
+        };
+
+        void evictBack();
+
+        size_t budget;
+        size_t bytes;
+        size_t hits, misses, evictions;
+
+        std::list<Entry> entries; // Most recently used first
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+};
@@ -0,0 +1,188 @@
+#include "AssetManifest.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+using std::string;
+using std::vector;
+
+// Splits line at tabs, in place
+static vector<char *> split_fields(char *line)
+{
+    vector<char *> fields(1, line);
+    for (char *tab = strchr(line, '\t'); tab; tab = strchr(tab + 1, '\t'))
+    {
+        *tab = '\0';
+        fields.push_back(tab + 1);
+    }
+    return fields;
+}
+
+bool AssetManifest::load(const char *path)
+{
+    entries.clear();
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        return false;
+    }
+
+    char line[4096];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '#' || line[0] == '\0')
+        {
+            continue;
+        }
+
+        vector<char *> fields = split_fields(line);
+        char *size_end, *hash_end;
+        Entry entry;
+        ok = fields.size() == 5;
+        if (ok)
+        {
+            entry.type = fields[0];
+            entry.name = fields[1];
+            entry.path = fields[2];
+            entry.size = strtoull(fields[3], &size_end, 10);
+            entry.hash = strtoul(fields[4], &hash_end, 16);
+            ok = *fields[3] && !*size_end && *fields[4] && !*hash_end;
+        }
+        if (ok)
+        {
+            add(entry);
+        }
+    }
+
+    fclose(file);
+    if (!ok)
+    {
+        entries.clear();
+    }
+    return ok;
+}
+
+bool AssetManifest::save(const char *path) const
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    bool ok = fprintf(file, "# type\tname\tpath\tsize\thash\n") > 0;
+    for (auto it = entries.begin(); ok && it != entries.end(); ++it)
+    {
+        const Entry &entry = it->second;
+        ok = fprintf(file, "%s\t%s\t%s\t%llu\t%08x\n", entry.type.c_str(), entry.name.c_str(),
+                     entry.path.c_str(), (unsigned long long)entry.size, (unsigned)entry.hash) > 0;
+    }
+
+    return fclose(file) == 0 && ok;
+}
+
+const AssetManifest::Entry *AssetManifest::find(const string &path) const
+{
+    auto found = entries.find(path);
+    return found == entries.end() ? NULL : &found->second;
+}
+
+/*******************************************************************************
+Extensions of the formats the Allegro image, ttf and acodec addons load.
+*******************************************************************************/
+static const char *const BITMAP_EXTENSIONS[] = { ".png", ".jpg", ".jpeg", ".bmp", ".pcx", ".tga", ".webp", ".dds" };
+static const char *const FONT_EXTENSIONS[] = { ".ttf", ".otf", ".ttc" };
+static const char *const SAMPLE_EXTENSIONS[] = { ".wav", ".ogg", ".flac", ".opus", ".voc", ".mod", ".s3m", ".xm",
+                                                 ".it" };
+
+// Formats whose files don't start with a signature
+static const char *const UNSIGNED_EXTENSIONS[] = { ".tga", ".voc", ".mod", ".s3m" };
+
+template <size_t N>
+static bool has_extension(const string &path, const char *const (&extensions)[N])
+{
+    size_t dot = path.rfind('.');
+    if (dot == string::npos)
+    {
+        return false;
+    }
+
+    string extension = path.substr(dot);
+    for (size_t i = 0; i < extension.size(); i++)
+    {
+        extension[i] = tolower((unsigned char)extension[i]);
+    }
+
+    for (size_t i = 0; i < N; i++)
+    {
+        if (extension == extensions[i])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *AssetManifest::typeOf(const string &path)
+{
+    if (has_extension(path, BITMAP_EXTENSIONS))
+    {
+        return "bitmap";
+    }
+    if (has_extension(path, FONT_EXTENSIONS))
+    {
+        return "font";
+    }
+    if (has_extension(path, SAMPLE_EXTENSIONS))
+    {
+        return "sample";
+    }
+    return NULL;
+}
+
+static bool starts_with(const char *header, size_t length, const char *signature, size_t signature_length,
+                        size_t offset = 0)
+{
+    return length >= offset + signature_length && memcmp(header + offset, signature, signature_length) == 0;
+}
+
+static bool is_image(const char *header, size_t length)
+{
+    return starts_with(header, length, "\x89PNG\r\n\x1a\n", 8) || starts_with(header, length, "\xff\xd8\xff", 3)
+           || starts_with(header, length, "BM", 2) || starts_with(header, length, "\x0a", 1)
+           || (starts_with(header, length, "RIFF", 4) && starts_with(header, length, "WEBP", 4, 8))
+           || starts_with(header, length, "DDS ", 4);
+}
+
+bool AssetManifest::sniff(const char *type, const string &path, const char *header, size_t length)
+{
+    const char *expected = typeOf(path);
+    if (expected && strcmp(expected, type) == 0 && has_extension(path, UNSIGNED_EXTENSIONS))
+    {
+        return true;
+    }
+
+    if (strcmp(type, "bitmap") == 0)
+    {
+        return is_image(header, length);
+    }
+
+    if (strcmp(type, "font") == 0)
+    {
+        return starts_with(header, length, "\x00\x01\x00\x00", 4) || starts_with(header, length, "OTTO", 4)
+               || starts_with(header, length, "true", 4) || starts_with(header, length, "ttcf", 4)
+               || is_image(header, length);
+    }
+
+    if (strcmp(type, "sample") == 0)
+    {
+        return (starts_with(header, length, "RIFF", 4) && starts_with(header, length, "WAVE", 4, 8))
+               || starts_with(header, length, "OggS", 4) || starts_with(header, length, "fLaC", 4)
+               || starts_with(header, length, "Extended Module", 15) || starts_with(header, length, "IMPM", 4);
+    }
+
+    return false;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/***************************************************************************//**
+An AssetManifest lists the assets shipped with the game: for each, its type,
+name, path, size in bytes and a content hash. It is written by assetpack when
+the game is built, so at startup Assets can check that an asset is present and
+unchanged in size with a single stat, instead of loading it.\n
+The manifest is a text file with one asset per line, its fields separated by
+tabs:
+\verbatim
+bitmap	main_menu	bitmaps/main_menu.png	482113	9c1d27e4
+\endverbatim
+Paths are relative to the asset directory, and the hash is
+AssetArchive::checksum in hexadecimal. Lines starting with # are comments.
+*******************************************************************************/
+class AssetManifest
+{
+    public:
+        struct Entry {
+            std::string type; // "bitmap", "font" or "sample"
+            std::string name;
+            std::string path;
+            uint64_t size;
+            uint32_t hash;
+        };
+
+/***************************************************************************//**
+@fn bool load(const char *path)
+Reads the manifest at path, replacing any entries. Returns false, leaving the
+manifest empty, if it is missing or a line can't be read.
+@fn bool save(const char *path) const
+Writes the manifest to path, sorted by path. Returns false if it can't.
+*******************************************************************************/
+        bool load(const char *path);
+        bool save(const char *path) const;
+
+/***************************************************************************//**
+@fn void add(const Entry &entry)
+Adds entry, replacing any entry with the same path.
+@fn const Entry *find(const std::string &path) const
+Returns the entry for the asset at path, or NULL if there is none.
+@fn size_t size() const
+Returns the number of entries.
+*******************************************************************************/
+        void add(const Entry &entry) { entries[entry.path] = entry; }
+        const Entry *find(const std::string &path) const;
+        size_t size() const { return entries.size(); }
+
+/***************************************************************************//**
+@fn static const char *typeOf(const std::string &path)
+Returns the asset type the extension of path stands for, or NULL if it is
+none Assets loads.
+@fn static bool sniff(const char *type, const std::string &path, const char *header, size_t length)
+Returns true if header, the first length bytes of the file at path, starts
+like an asset of type. Formats without a signature, such as TGA images or
+tracker music, are accepted on their extension. Fonts may be TrueType or
+OpenType files, or images holding bitmap fonts.
+*******************************************************************************/
+        static const char *typeOf(const std::string &path);
+        static bool sniff(const char *type, const std::string &path, const char *header, size_t length);
+
+/***************************************************************************//**
+@var SNIFF_LENGTH
+The number of bytes sniff needs to recognize any format.
+*******************************************************************************/
+        static const size_t SNIFF_LENGTH = 16;
+
+    private:
+        std::map<std::string, Entry> entries; // By path
+};
@@ -0,0 +1,243 @@
+/*******************************************************************************
+assetpack writes an ::AssetArchive holding every file under a directory, for
+Assets to load instead of the loose files, or with -m an ::AssetManifest
+listing the assets under it, for Assets to check them against at startup.
+make builds both alongside the game, and again whenever an asset changes; by
+hand that is
+\verbatim
+make assetpack
+./assetpack assets assets/assets.pak
+./assetpack -m assets assets/assets.manifest
+\endverbatim
+Files and directories starting with a dot, archives (.pak), manifests and the
+nav directory, where the game bakes its navigation meshes at runtime, are left
+out. Asset names in the archive, and paths in the manifest, are relative
+to the packed directory. The manifest only lists files of a type Assets loads,
+named after their file name minus the extension.
+*******************************************************************************/
+
+#include "AssetArchive.h"
+#include "AssetManifest.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+using std::string;
+using std::vector;
+
+// Contents of every asset start on a multiple of this
+static const size_t ALIGNMENT = 16;
+
+// Directory of the packed tree that Mesh::bake writes to, which isn't an asset
+static const char *NAV_DIRECTORY = "nav";
+
+struct Asset
+{
+    string name;
+    vector<char> contents;
+};
+
+static bool read_file(const string &path, vector<char> &contents)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    contents.resize(size > 0 ? size : 0);
+    bool ok = size >= 0 && (size == 0 || fread(&contents[0], size, 1, file) == 1);
+    fclose(file);
+    return ok;
+}
+
+/*******************************************************************************
+Adds every file under root + "/" + prefix to assets, naming each by its path
+from root.
+*******************************************************************************/
+static bool collect(const string &root, const string &prefix, vector<Asset> &assets)
+{
+    string directory = prefix.empty() ? root : root + "/" + prefix;
+    DIR *dir = opendir(directory.c_str());
+    if (!dir)
+    {
+        fprintf(stderr, "could not open %s\n", directory.c_str());
+        return false;
+    }
+
+    bool ok = true;
+    while (struct dirent *item = readdir(dir))
+    {
+        string file = item->d_name;
+        if (file[0] == '.' || (file.size() > 4 && file.compare(file.size() - 4, 4, ".pak") == 0)
+            || (file.size() > 9 && file.compare(file.size() - 9, 9, ".manifest") == 0)
+            || (prefix.empty() && file == NAV_DIRECTORY))
+        {
+            continue;
+        }
+
+        string name = prefix.empty() ? file : prefix + "/" + file;
+        string path = root + "/" + name;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+        {
+            continue;
+        }
+
+        if (S_ISDIR(info.st_mode))
+        {
+            ok = collect(root, name, assets) && ok;
+        }
+        else if (S_ISREG(info.st_mode))
+        {
+            Asset asset;
+            asset.name = name;
+            if (!read_file(path, asset.contents))
+            {
+                fprintf(stderr, "could not read %s\n", path.c_str());
+                ok = false;
+                continue;
+            }
+            assets.push_back(asset);
+        }
+    }
+
+    closedir(dir);
+    return ok;
+}
+
+static bool by_name(const Asset &a, const Asset &b)
+{
+    return a.name < b.name;
+}
+
+static size_t align(size_t offset)
+{
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+static bool write_manifest(const vector<Asset> &assets, const char *path)
+{
+    AssetManifest manifest;
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        const Asset &asset = assets[i];
+        const char *type = AssetManifest::typeOf(asset.name);
+        if (!type)
+        {
+            continue;
+        }
+
+        size_t slash = asset.name.rfind('/');
+        string file = slash == string::npos ? asset.name : asset.name.substr(slash + 1);
+        AssetManifest::Entry entry;
+        entry.type = type;
+        entry.name = file.substr(0, file.rfind('.'));
+        entry.path = asset.name;
+        entry.size = asset.contents.size();
+        entry.hash = AssetArchive::checksum(asset.contents.data(), asset.contents.size());
+        manifest.add(entry);
+    }
+
+    if (!manifest.save(path))
+    {
+        fprintf(stderr, "could not write %s\n", path);
+        return false;
+    }
+
+    printf("listed %d assets in %s\n", (int)manifest.size(), path);
+    return true;
+}
+
+static bool write_archive(const vector<Asset> &assets, const char *path)
+{
+    AssetArchive::Header header;
+    memcpy(header.magic, AssetArchive::MAGIC, sizeof(header.magic));
+    header.version = AssetArchive::FORMAT_VERSION;
+    header.count = assets.size();
+    header.names_size = 0;
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        header.names_size += assets[i].name.size();
+    }
+
+    // Lay out the index, names, then the contents
+    vector<AssetArchive::Entry> entries(assets.size());
+    size_t name_offset = 0;
+    size_t offset = align(sizeof(header) + entries.size() * sizeof(AssetArchive::Entry) + header.names_size);
+    for (size_t i = 0; i < assets.size(); i++)
+    {
+        const Asset &asset = assets[i];
+        AssetArchive::Entry &entry = entries[i];
+        entry.name_offset = name_offset;
+        entry.name_length = asset.name.size();
+        entry.offset = offset;
+        entry.size = asset.contents.size();
+        entry.checksum = AssetArchive::checksum(asset.contents.data(), asset.contents.size());
+        entry.padding = 0;
+        name_offset += asset.name.size();
+        offset = align(offset + asset.contents.size());
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "could not write %s\n", path);
+        return false;
+    }
+
+    static const char zeros[ALIGNMENT] = { 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+              && (entries.empty() || fwrite(&entries[0], sizeof(entries[0]), entries.size(), file) == entries.size());
+    for (size_t i = 0; ok && i < assets.size(); i++)
+    {
+        ok = fwrite(assets[i].name.data(), 1, assets[i].name.size(), file) == assets[i].name.size();
+    }
+
+    long position = ftell(file);
+    for (size_t i = 0; ok && i < assets.size(); i++)
+    {
+        size_t padding = entries[i].offset - position;
+        const vector<char> &contents = assets[i].contents;
+        ok = fwrite(zeros, 1, padding, file) == padding
+             && fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+        position = entries[i].offset + contents.size();
+    }
+
+    if (fclose(file) != 0 || !ok)
+    {
+        fprintf(stderr, "could not write %s\n", path);
+        return false;
+    }
+
+    printf("packed %d assets into %s, %ld bytes\n", (int)assets.size(), path, position);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    bool manifest = argc == 4 && strcmp(argv[1], "-m") == 0;
+    if (argc != 3 && !manifest)
+    {
+        fprintf(stderr, "usage: %s [-m] directory output\n", argv[0]);
+        return 1;
+    }
+
+    const char *directory = argv[argc - 2];
+    const char *output = argv[argc - 1];
+    vector<Asset> assets;
+    if (!collect(directory, "", assets))
+    {
+        return 1;
+    }
+    std::sort(assets.begin(), assets.end(), by_name);
+
+    bool ok = manifest ? write_manifest(assets, output) : write_archive(assets, output);
+    return ok ? 0 : 1;
+}
@@ -48,12 +48,63 @@ explained now.
   loaded multiple times into memory, and improves load times of assets currently
   in use.
 
+Facile assets are also retained after their last reference is gone, by an LRU
+cache with a byte budget (see ::AssetCache). An asset that is used on and off,
+such as a level background or boss music, then stays in memory until newer
+assets push it past the budget, instead of being read from disk every time it
+returns. The budget is set with ::set_asset_budget, and ::get_asset_cache
+reports hits, misses and evictions.
+
+Facile assets can also be loaded in the background with ::find_bitmap_async,
+find_font_async, ::find_sample_async and ::prefetch. Each request is
+recorded in a pending table (name, promise) so asking twice loads once. Bitmaps
+and samples are decoded by a loader thread, bitmaps into memory bitmaps since
+only the game thread may touch the GPU; ::update_assets then turns them into
+video bitmaps, loads requested fonts, and fulfills the promises a few at a time
+each game cycle. Finished assets go into the weak tables like any other facile
+asset, and prefetched ones are also held in a prefetched table until they are
+first looked up.
+
+Urgent bitmaps up to half a page in size are gathered into atlas pages by
+::pack_urgent_bitmaps once they are loaded, and ::urgent_bitmaps then holds sub-bitmaps of those
+pages. Drawing a sub-bitmap draws part of its page, so consecutive draws of
+packed bitmaps use the same texture and Allegro can batch them when bitmap
+drawing is held.
+
+If the game directory holds an assets.pak archive (see ::AssetArchive), assets
+are read out of it rather than from their own files. Bitmaps, samples and
+TrueType fonts are handed to the Allegro loaders as memfiles over the mapped
+archive, so nothing is copied; anything missing from the archive, or whose
+checksum doesn't match, is loaded from disk as before.
+
+Code that looks assets up often can skip the string hashing: ::asset_id hashes
+a name at compile time, a handle function such as ::bitmap_handle turns the ID
+into a dense index once, and find_bitmap(asset_handle handle) and friends are
+then an array index. The string lookups remain for everything else.
+
+Facile assets aren't loaded when they are inserted, only checked: against the
+sizes listed in assets.manifest (see ::AssetManifest) when there is one, or
+else by the signature at the start of the file, so startup doesn't grow with
+the size of the asset library.
+
 You are responsible for loading the urgent tables and facile tables by modifying
 the functions ::load_bitmaps, ::load_fonts, and ::load_samples. Documentation 
 in those functions details how to do this properly.
 *******************************************************************************/
 #include "Assets.h"
+#include "AssetArchive.h"
+#include "AssetCache.h"
+#include "AssetManifest.h"
+#include "AtlasPacker.h"
+#include <allegro5/allegro_memfile.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 using namespace std;
 
 void insert_urgent_bitmap(string name, string path);
@@ -73,6 +124,148 @@ const string BITMAPS_PATH = ASSETS_PATH + "bitmaps/";
 const string FONTS_PATH = ASSETS_PATH + "fonts/";
 const string SAMPLES_PATH = ASSETS_PATH + "samples/";
 
+/*******************************************************************************
+Packed assets. If ARCHIVE_PATH holds an archive written by assetpack, every
+asset under ASSETS_PATH is read out of it instead of from its own file; assets
+it doesn't have are still loaded from disk.
+*******************************************************************************/
+const string ARCHIVE_PATH = ASSETS_PATH + "assets.pak";
+
+AssetArchive asset_archive;
+once_flag archive_opened;
+
+// The archive, mapped the first time any asset is loaded
+const AssetArchive &packed_assets()
+{
+    call_once(archive_opened, [] { asset_archive.open(ARCHIVE_PATH.c_str()); });
+    return asset_archive;
+}
+
+// The name of the asset at path in the archive and manifest, or "" if it isn't under ASSETS_PATH
+string packed_name(const string &path)
+{
+    return path.compare(0, ASSETS_PATH.size(), ASSETS_PATH) == 0 ? path.substr(ASSETS_PATH.size()) : "";
+}
+
+/*******************************************************************************
+Returns a memfile over the packed copy of the asset at path, or NULL if it
+isn't packed.
+*******************************************************************************/
+ALLEGRO_FILE *open_packed(const string &path)
+{
+    const char *contents;
+    size_t size;
+    string name = packed_name(path);
+    if (name.empty() || !packed_assets().find(name, contents, size))
+    {
+        return NULL;
+    }
+    return al_open_memfile((void *)contents, size, "r");
+}
+
+// The extension of path, dot included, which the Allegro loaders go by
+string extension(const string &path)
+{
+    size_t dot = path.rfind('.');
+    return dot == string::npos ? "" : path.substr(dot);
+}
+
+ALLEGRO_BITMAP *load_bitmap_file(const string &path)
+{
+    ALLEGRO_FILE *file = open_packed(path);
+    if (!file)
+    {
+        return al_load_bitmap(path.c_str());
+    }
+
+    ALLEGRO_BITMAP *bitmap = al_load_bitmap_f(file, extension(path).c_str());
+    al_fclose(file);
+    return bitmap;
+}
+
+/*******************************************************************************
+Only TrueType fonts can be read from a memfile; the font keeps reading glyphs
+from the file, and closes it when it is destroyed.
+*******************************************************************************/
+ALLEGRO_FONT *load_font_file(const string &path, int size)
+{
+    if (extension(path) != ".ttf")
+    {
+        return al_load_font(path.c_str(), size, 0);
+    }
+
+    ALLEGRO_FILE *file = open_packed(path);
+    if (!file)
+    {
+        return al_load_font(path.c_str(), size, 0);
+    }
+    return al_load_ttf_font_f(file, path.c_str(), size, 0);
+}
+
+ALLEGRO_SAMPLE *load_sample_file(const string &path)
+{
+    ALLEGRO_FILE *file = open_packed(path);
+    if (!file)
+    {
+        return al_load_sample(path.c_str());
+    }
+
+    ALLEGRO_SAMPLE *sample = al_load_sample_f(file, extension(path).c_str());
+    al_fclose(file);
+    return sample;
+}
+
+/*******************************************************************************
+Startup checks. The build runs assetpack -m to list every asset with its size
+in MANIFEST_PATH; an asset whose file has the listed size is taken to be fine
+after a stat. Any other asset has its first bytes checked for the signature of
+its type. Either way nothing is decoded until the asset is first looked up.
+*******************************************************************************/
+const string MANIFEST_PATH = ASSETS_PATH + "assets.manifest";
+
+AssetManifest asset_manifest;
+once_flag manifest_read;
+
+/*******************************************************************************
+Returns true if the asset at path is in the archive or on disk, and is listed
+in the manifest with its current size or looks like an asset of type.
+*******************************************************************************/
+bool check_asset(const string &path, const char *type)
+{
+    call_once(manifest_read, [] { asset_manifest.load(MANIFEST_PATH.c_str()); });
+
+    string name = packed_name(path);
+    const AssetManifest::Entry *entry = name.empty() ? NULL : asset_manifest.find(name);
+    bool listed = entry && entry->type == type;
+
+    const char *contents;
+    size_t size;
+    if (!name.empty() && packed_assets().peek(name, contents, size))
+    {
+        return (listed && entry->size == size) || AssetManifest::sniff(type, path, contents, size);
+    }
+
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        return false;
+    }
+    if (listed && entry->size == (uint64_t)info.st_size)
+    {
+        return true;
+    }
+
+    char header[AssetManifest::SNIFF_LENGTH];
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    size_t length = fread(header, 1, sizeof(header), file);
+    fclose(file);
+    return AssetManifest::sniff(type, path, header, length);
+}
+
 /*******************************************************************************
 *** Load your new assets here
 ****************************************************************************//**
@@ -206,6 +399,121 @@ unordered_map <string, shared_sample> urgent_samples;
 unordered_map <string, weak_sample> weak_samples;
 unordered_map <string, string> facile_samples;
 
+/*******************************************************************************
+Background loading. A LoadJob is one facile asset on its way in; the loader
+thread fills in bitmap or sample. Only the queues are shared with the loader
+thread; everything else belongs to the game thread.
+*******************************************************************************/
+enum AssetType { BITMAP_ASSET, FONT_ASSET, SAMPLE_ASSET };
+
+struct LoadJob
+{
+    AssetType type;
+    string name; // Key in the pending table
+    string path;
+    int size;
+    ALLEGRO_BITMAP *bitmap;
+    ALLEGRO_SAMPLE *sample;
+};
+
+template <class Asset>
+struct PendingAsset
+{
+    promise<Asset> loaded;
+    shared_future<Asset> future;
+    bool prefetched;
+};
+
+unordered_map <string, PendingAsset<shared_bitmap> > pending_bitmaps;
+unordered_map <string, PendingAsset<shared_font> > pending_fonts;
+unordered_map <string, PendingAsset<shared_sample> > pending_samples;
+
+unordered_map <string, shared_bitmap> prefetched_bitmaps;
+unordered_map <string, shared_sample> prefetched_samples;
+
+thread asset_loader;
+mutex loader_mutex;
+condition_variable loader_wake;
+deque<LoadJob> load_queue;    // Waiting for the loader thread
+deque<LoadJob> decoded_queue; // Decoded, waiting for update_assets
+deque<LoadJob> font_queue;    // Waiting for update_assets; game thread only
+bool loader_stopping = false;
+
+/***************************************************************************//**
+@var AssetCache retained_assets
+@ingroup asset_tables_group
+Holds on to facile assets after their last user lets go, least recently used
+first out once their estimated size exceeds the budget set by
+::set_asset_budget. Keys are the asset's key in its weak table, prefixed with
+its type, since a bitmap and a sample may share a name.
+*******************************************************************************/
+AssetCache retained_assets;
+
+// Glyphs a font is assumed to cache, for estimating its size
+const int FONT_GLYPHS = 96;
+
+string retained_key(AssetType type, const string &key)
+{
+    static const char *const TYPE_NAMES[] = { "bitmap:", "font:", "sample:" };
+    return TYPE_NAMES[type] + key;
+}
+
+/*******************************************************************************
+Estimates of the memory an asset occupies: the pixels of a bitmap, a glyph
+cache of FONT_GLYPHS square glyphs for a font, and the sample data of a sample.
+*******************************************************************************/
+size_t asset_bytes(ALLEGRO_BITMAP *bitmap)
+{
+    return (size_t)al_get_bitmap_width(bitmap) * al_get_bitmap_height(bitmap)
+           * al_get_pixel_size(al_get_bitmap_format(bitmap));
+}
+
+size_t asset_bytes(ALLEGRO_FONT *font)
+{
+    size_t height = al_get_font_line_height(font);
+    return FONT_GLYPHS * height * height * 4;
+}
+
+size_t asset_bytes(ALLEGRO_SAMPLE *sample)
+{
+    return (size_t)al_get_sample_length(sample) * al_get_channel_count(al_get_sample_channels(sample))
+           * al_get_audio_depth_size(al_get_sample_depth(sample));
+}
+
+template <class Asset>
+void retain(AssetType type, const string &key, const Asset &asset)
+{
+    if (asset)
+    {
+        retained_assets.insert(retained_key(type, key), asset, asset_bytes(asset.get()));
+    }
+}
+
+// True if the asset under key is in memory, so looking it up won't load it
+template <class Element>
+bool in_memory(AssetType type, unordered_map<string, weak_ptr<Element> > &weak, const string &key)
+{
+    return !weak[key].expired() || retained_assets.contains(retained_key(type, key));
+}
+
+/***************************************************************************//**
+@fn void set_asset_budget(size_t bytes)
+@ingroup assets_group
+Sets the budget of ::retained_assets, dropping assets if it shrinks.
+@fn const AssetCache &get_asset_cache()
+@ingroup assets_group
+Returns ::retained_assets, for its size and counters.
+*******************************************************************************/
+void set_asset_budget(size_t bytes)
+{
+    retained_assets.setBudget(bytes);
+}
+
+const AssetCache &get_asset_cache()
+{
+    return retained_assets;
+}
+
 /***************************************************************************//**
 @fn shared_bitmap make_shared_bitmap(ALLEGRO_BITMAP *bmp)
 @ingroup assets_group
@@ -253,13 +561,17 @@ NULL will be returned if unsuccessful.
 
 ::weak_bitmaps will be searched second. This search will only succeed if a bitmap 
 was previously looked up in facile_bitmaps, and there is still an existing
-reference to that bitmap.
+reference to that bitmap. A bitmap waiting in the prefetched table is taken
+from there first, so it is only held by its users from then on, and one kept by
+::retained_assets is taken from there before the weak table is tried.
 
 ::facile_bitmaps will be searched last. If an entry is found here, then a new
 shared_bitmap will be loaded into memory from disk, and an entry will be made
-into weak_bitmaps to save time on future look ups.
+into weak_bitmaps to save time on future look ups. Bitmaps found in the weak
+table or loaded from disk are (re)retained, so they stay in memory for a while
+after their last user lets go.
 *******************************************************************************/
-shared_bitmap find_bitmap(string name) 
+shared_bitmap find_bitmap(const string &name)
 {
     auto bitmap1 = urgent_bitmaps.find(name);
     if (bitmap1 != urgent_bitmaps.end())
@@ -267,11 +579,28 @@ shared_bitmap find_bitmap(string name)
         return bitmap1->second;
     }
 
+    auto prefetched = prefetched_bitmaps.find(name);
+    if (prefetched != prefetched_bitmaps.end())
+    {
+        shared_bitmap bitmap = prefetched->second;
+        prefetched_bitmaps.erase(prefetched);
+        return bitmap;
+    }
+
+    if (facile_bitmaps.count(name))
+    {
+        if (auto retained = retained_assets.find(retained_key(BITMAP_ASSET, name)))
+        {
+            return static_pointer_cast<ALLEGRO_BITMAP>(retained);
+        }
+    }
+
     auto bitmap2 = weak_bitmaps.find(name);
       if (bitmap2 != weak_bitmaps.end())
       {
           if (auto wp = bitmap2->second.lock())
           {
+              retain(BITMAP_ASSET, name, wp);
               return wp;
           }
           else
@@ -283,8 +612,9 @@ shared_bitmap find_bitmap(string name)
       auto path = facile_bitmaps.find(name);
       if (path != facile_bitmaps.end())
       {
-        shared_bitmap bitmap = make_shared_bitmap(al_load_bitmap(path->second.c_str()));
+        shared_bitmap bitmap = make_shared_bitmap(load_bitmap_file(path->second));
         weak_bitmaps[name] = weak_bitmap (bitmap);
+        retain(BITMAP_ASSET, name, bitmap);
         return bitmap;
       }
 
@@ -296,7 +626,7 @@ shared_bitmap find_bitmap(string name)
 This find_font will only search ::urgent_fonts for the location at name. NULL will 
 be returned if the requested font was not found.\n
 *******************************************************************************/
-shared_font find_font(string name) 
+shared_font find_font(const string &name)
 {
     auto font1 = urgent_fonts.find(name);
     if (font1 != urgent_fonts.end())
@@ -317,6 +647,8 @@ into the function; rather we're looking for something like name+size.
 
 ie. If name = "times" and size = 48, then we search weak_fonts for "times48".
 
+::retained_assets is searched before weak_fonts, under the same name.
+
 If we don't find it in weak_fonts, or all external references are no longer
 valid, we continue our search in ::facile_fonts.
 
@@ -324,17 +656,26 @@ We will search for just the name in facile_fonts. If we find it, then we will
 load the font into memory at the specified size using make_shared_font. We will
 then create a weak_font out of this shared_font, and load the font into
 weak_fonts using the naming convention mentioned above. The shared pointer is
-then returned.
+then returned. Like bitmaps, fonts found in weak_fonts or loaded are retained.
 *******************************************************************************/
-shared_font find_font(string name, int size) 
+shared_font find_font(const string &name, int size)
 {
     string fname(name + to_string(size));
 
+    if (facile_fonts.count(name))
+    {
+        if (auto retained = retained_assets.find(retained_key(FONT_ASSET, fname)))
+        {
+            return static_pointer_cast<ALLEGRO_FONT>(retained);
+        }
+    }
+
     auto font2 = weak_fonts.find(fname);
       if (font2 != weak_fonts.end())
       {
           if (auto wp = font2->second.lock())
           { 
+              retain(FONT_ASSET, fname, wp);
               return wp;
           }
           else
@@ -346,8 +687,9 @@ shared_font find_font(string name, int size)
     auto font3 = facile_fonts.find(name);
     if (font3 != facile_fonts.end())
     {
-        shared_font font = make_shared_font(al_load_font(font3->second.c_str(), size, 0));
+        shared_font font = make_shared_font(load_font_file(font3->second, size));
         weak_fonts[fname] = weak_font(font);
+        retain(FONT_ASSET, fname, font);
         return font;
     }
 
@@ -359,7 +701,7 @@ shared_font find_font(string name, int size)
 This function is almost identical to ::find_bitmap, though its return value is a
 shared_sample instead of shared_bitmap.
 *******************************************************************************/
-shared_sample find_sample(string name) 
+shared_sample find_sample(const string &name)
 {
     auto sample1 = urgent_samples.find(name);
     if (sample1 != urgent_samples.end())
@@ -367,11 +709,28 @@ shared_sample find_sample(string name)
         return sample1->second;
     }
 
+    auto prefetched = prefetched_samples.find(name);
+    if (prefetched != prefetched_samples.end())
+    {
+        shared_sample sample = prefetched->second;
+        prefetched_samples.erase(prefetched);
+        return sample;
+    }
+
+    if (facile_samples.count(name))
+    {
+        if (auto retained = retained_assets.find(retained_key(SAMPLE_ASSET, name)))
+        {
+            return static_pointer_cast<ALLEGRO_SAMPLE>(retained);
+        }
+    }
+
     auto sample2 = weak_samples.find(name);
       if (sample2 != weak_samples.end())
       {
           if (auto wp = sample2->second.lock())
           {
+              retain(SAMPLE_ASSET, name, wp);
               return wp;
           }
           else
@@ -383,14 +742,502 @@ shared_sample find_sample(string name)
       auto path = facile_samples.find(name);
       if (path != facile_samples.end())
       {
-        shared_sample sample3 = make_shared_sample(al_load_sample(path->second.c_str()));
+        shared_sample sample3 = make_shared_sample(load_sample_file(path->second));
         weak_samples[name] = weak_sample(sample3);
+        retain(SAMPLE_ASSET, name, sample3);
         return sample3;
       }
 
     return NULL;
 }
 
+/*******************************************************************************
+Asset handles. Every name inserted is recorded under its ID, and the first time
+an ID is resolved it gets the next slot of the table. A slot remembers its
+asset once found: urgent assets for good, facile ones through a weak pointer,
+so a handle lookup only goes back to the name lookup when the asset has to be
+found or loaded again. Fonts are resolved by ID and size, size 0 standing for
+the urgent font.
+*******************************************************************************/
+template <class Asset>
+struct AssetSlot
+{
+    string name;
+    int size;
+    Asset urgent;
+    weak_ptr<typename Asset::element_type> loaded;
+};
+
+template <class Asset>
+struct HandleTable
+{
+    unordered_map<AssetId, string> names;
+    unordered_map<uint64_t, asset_handle> handles; // By ID and size
+    vector<AssetSlot<Asset> > slots;
+};
+
+HandleTable<shared_bitmap> bitmap_handles;
+HandleTable<shared_font> font_handles;
+HandleTable<shared_sample> sample_handles;
+
+template <class Asset>
+void register_name(HandleTable<Asset> &table, const string &name)
+{
+    auto inserted = table.names.insert(make_pair(asset_id(name.c_str()), name));
+    if (!inserted.second && inserted.first->second != name)
+    {
+        printf("Assets %s and %s have the same ID; %s can only be found by name\n",
+               inserted.first->second.c_str(), name.c_str(), name.c_str());
+    }
+}
+
+template <class Asset>
+asset_handle resolve(HandleTable<Asset> &table, AssetId id, int size)
+{
+    uint64_t key = (uint64_t)id << 32 | (uint32_t)size;
+    auto found = table.handles.find(key);
+    if (found != table.handles.end())
+    {
+        return found->second;
+    }
+
+    auto name = table.names.find(id);
+    if (name == table.names.end())
+    {
+        return -1;
+    }
+
+    AssetSlot<Asset> slot;
+    slot.name = name->second;
+    slot.size = size;
+    table.slots.push_back(slot);
+    return table.handles[key] = table.slots.size() - 1;
+}
+
+/*******************************************************************************
+Looks the asset in slot handle up by name with find the first time, and keeps
+it in the slot.
+*******************************************************************************/
+template <class Asset, class Find>
+Asset find_slot(HandleTable<Asset> &table, asset_handle handle, const unordered_map<string, Asset> &urgent,
+                Find find)
+{
+    if (handle < 0 || handle >= (int)table.slots.size())
+    {
+        return Asset();
+    }
+
+    AssetSlot<Asset> &slot = table.slots[handle];
+    if (slot.urgent)
+    {
+        return slot.urgent;
+    }
+    if (Asset asset = slot.loaded.lock())
+    {
+        return asset;
+    }
+
+    Asset asset = find(slot);
+    if (slot.size == 0 && urgent.count(slot.name))
+    {
+        slot.urgent = asset;
+    }
+    else
+    {
+        slot.loaded = asset;
+    }
+    return asset;
+}
+
+/***************************************************************************//**
+@fn asset_handle bitmap_handle(AssetId id)
+@ingroup assets_group
+@fn asset_handle font_handle(AssetId id)
+@ingroup assets_group
+@fn asset_handle font_handle(AssetId id, int size)
+@ingroup assets_group
+@fn asset_handle sample_handle(AssetId id)
+@ingroup assets_group
+These hash only the integer ID, so resolving is cheap, but not free: keep the
+handle rather than resolving it every frame.
+*******************************************************************************/
+asset_handle bitmap_handle(AssetId id)
+{
+    return resolve(bitmap_handles, id, 0);
+}
+
+asset_handle font_handle(AssetId id)
+{
+    return resolve(font_handles, id, 0);
+}
+
+asset_handle font_handle(AssetId id, int size)
+{
+    return size > 0 ? resolve(font_handles, id, size) : -1;
+}
+
+asset_handle sample_handle(AssetId id)
+{
+    return resolve(sample_handles, id, 0);
+}
+
+/***************************************************************************//**
+@fn shared_bitmap find_bitmap(asset_handle handle)
+@ingroup assets_group
+@fn shared_font find_font(asset_handle handle)
+@ingroup assets_group
+@fn shared_sample find_sample(asset_handle handle)
+@ingroup assets_group
+A facile asset found through its slot isn't moved to the front of
+::retained_assets, since that takes a string lookup; it is while its slot has
+to look it up by name.
+*******************************************************************************/
+shared_bitmap find_bitmap(asset_handle handle)
+{
+    return find_slot(bitmap_handles, handle, urgent_bitmaps, [](const AssetSlot<shared_bitmap> &slot) {
+        return find_bitmap(slot.name);
+    });
+}
+
+shared_font find_font(asset_handle handle)
+{
+    return find_slot(font_handles, handle, urgent_fonts, [](const AssetSlot<shared_font> &slot) {
+        return slot.size ? find_font(slot.name, slot.size) : find_font(slot.name);
+    });
+}
+
+shared_sample find_sample(asset_handle handle)
+{
+    return find_slot(sample_handles, handle, urgent_samples, [](const AssetSlot<shared_sample> &slot) {
+        return find_sample(slot.name);
+    });
+}
+
+/*******************************************************************************
+Returns a future that is already ready with asset.
+*******************************************************************************/
+template <class Asset>
+shared_future<Asset> ready_future(Asset asset)
+{
+    promise<Asset> loaded;
+    loaded.set_value(asset);
+    return loaded.get_future().share();
+}
+
+/*******************************************************************************
+Decodes jobs until unload_assets stops it. Bitmaps made on this thread are
+memory bitmaps, which don't need the display; update_assets uploads them.
+*******************************************************************************/
+void load_in_background()
+{
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+
+    unique_lock<mutex> lock(loader_mutex);
+    for (;;)
+    {
+        loader_wake.wait(lock, [] { return loader_stopping || !load_queue.empty(); });
+        if (loader_stopping)
+        {
+            return;
+        }
+
+        LoadJob job = load_queue.front();
+        load_queue.pop_front();
+        lock.unlock();
+
+        if (job.type == BITMAP_ASSET)
+        {
+            job.bitmap = load_bitmap_file(job.path);
+        }
+        else
+        {
+            job.sample = load_sample_file(job.path);
+        }
+
+        lock.lock();
+        decoded_queue.push_back(job);
+    }
+}
+
+/*******************************************************************************
+Records a request for the asset under key in pending, and queues job unless the
+asset is already on its way. Returns the future every request for it shares.
+*******************************************************************************/
+template <class Asset>
+shared_future<Asset> request_asset(unordered_map<string, PendingAsset<Asset> > &pending, const string &key,
+                                   const LoadJob &job, bool prefetched)
+{
+    auto found = pending.find(key);
+    if (found != pending.end())
+    {
+        found->second.prefetched = found->second.prefetched || prefetched;
+        return found->second.future;
+    }
+
+    PendingAsset<Asset> &entry = pending[key];
+    entry.future = entry.loaded.get_future().share();
+    entry.prefetched = prefetched;
+
+    if (job.type == FONT_ASSET)
+    {
+        font_queue.push_back(job);
+        return entry.future;
+    }
+
+    if (!asset_loader.joinable())
+    {
+        loader_stopping = false;
+        asset_loader = thread(load_in_background);
+    }
+
+    loader_mutex.lock();
+    load_queue.push_back(job);
+    loader_mutex.unlock();
+    loader_wake.notify_one();
+    return entry.future;
+}
+
+LoadJob make_job(AssetType type, const string &name, const string &path, int size)
+{
+    LoadJob job;
+    job.type = type;
+    job.name = name;
+    job.path = path;
+    job.size = size;
+    job.bitmap = NULL;
+    job.sample = NULL;
+    return job;
+}
+
+/*******************************************************************************
+Takes a finished asset out of pending, makes it findable through the weak
+table, retains it and fulfills its future.
+*******************************************************************************/
+template <class Asset>
+void finish_asset(AssetType type, unordered_map<string, PendingAsset<Asset> > &pending, const string &key,
+                  unordered_map<string, weak_ptr<typename Asset::element_type> > &weak,
+                  unordered_map<string, Asset> *prefetched, Asset asset)
+{
+    auto found = pending.find(key);
+    if (found == pending.end())
+    {
+        return;
+    }
+
+    if (asset)
+    {
+        weak[key] = asset;
+        retain(type, key, asset);
+        if (prefetched && found->second.prefetched)
+        {
+            (*prefetched)[key] = asset;
+        }
+    }
+    found->second.loaded.set_value(asset);
+    pending.erase(found);
+}
+
+/***************************************************************************//**
+@ingroup assets_group
+Looks the bitmap up the way ::find_bitmap does, except that a bitmap that has
+to come from disk is queued for the loader thread instead.
+*******************************************************************************/
+bitmap_future find_bitmap_async(string name)
+{
+    auto path = facile_bitmaps.find(name);
+    if (path == facile_bitmaps.end() || prefetched_bitmaps.count(name)
+        || in_memory(BITMAP_ASSET, weak_bitmaps, name))
+    {
+        return ready_future(find_bitmap(name));
+    }
+
+    return request_asset(pending_bitmaps, name, make_job(BITMAP_ASSET, name, path->second, 0), false);
+}
+
+/***************************************************************************//**
+@ingroup assets_group
+Looks the font up the way find_font(string name, int size) does, except that a
+font that has to come from disk is queued for ::update_assets instead.
+*******************************************************************************/
+font_future find_font_async(string name, int size)
+{
+    string fname(name + to_string(size));
+    auto path = facile_fonts.find(name);
+    if (path == facile_fonts.end() || in_memory(FONT_ASSET, weak_fonts, fname))
+    {
+        return ready_future(find_font(name, size));
+    }
+
+    return request_asset(pending_fonts, fname, make_job(FONT_ASSET, fname, path->second, size), false);
+}
+
+/***************************************************************************//**
+@ingroup assets_group
+Looks the sample up the way ::find_sample does, except that a sample that has
+to come from disk is queued for the loader thread instead.
+*******************************************************************************/
+sample_future find_sample_async(string name)
+{
+    auto path = facile_samples.find(name);
+    if (path == facile_samples.end() || prefetched_samples.count(name)
+        || in_memory(SAMPLE_ASSET, weak_samples, name))
+    {
+        return ready_future(find_sample(name));
+    }
+
+    return request_asset(pending_samples, name, make_job(SAMPLE_ASSET, name, path->second, 0), false);
+}
+
+/***************************************************************************//**
+@ingroup assets_group
+Queues the facile bitmap and sample called name, unless they are already in
+memory. Fonts can't be prefetched, since their size isn't known yet.
+*******************************************************************************/
+void prefetch(string name)
+{
+    auto bitmap = facile_bitmaps.find(name);
+    if (bitmap != facile_bitmaps.end() && !prefetched_bitmaps.count(name)
+        && !in_memory(BITMAP_ASSET, weak_bitmaps, name))
+    {
+        request_asset(pending_bitmaps, name, make_job(BITMAP_ASSET, name, bitmap->second, 0), true);
+    }
+
+    auto sample = facile_samples.find(name);
+    if (sample != facile_samples.end() && !prefetched_samples.count(name)
+        && !in_memory(SAMPLE_ASSET, weak_samples, name))
+    {
+        request_asset(pending_samples, name, make_job(SAMPLE_ASSET, name, sample->second, 0), true);
+    }
+}
+
+/***************************************************************************//**
+@ingroup assets_group
+Finishes decoded bitmaps and samples first, then requested fonts. A bitmap is
+uploaded by cloning the memory bitmap while the game thread's default flags
+ask for a video bitmap; if that fails the memory bitmap is kept, which still
+draws, only slower.
+*******************************************************************************/
+void update_assets(double budget)
+{
+    auto start = chrono::steady_clock::now();
+    for (bool first = true; ; first = false)
+    {
+        if (!first && chrono::duration<double>(chrono::steady_clock::now() - start).count() >= budget)
+        {
+            return;
+        }
+
+        LoadJob job;
+        loader_mutex.lock();
+        bool decoded = !decoded_queue.empty();
+        if (decoded)
+        {
+            job = decoded_queue.front();
+            decoded_queue.pop_front();
+        }
+        loader_mutex.unlock();
+
+        if (!decoded)
+        {
+            if (font_queue.empty())
+            {
+                return;
+            }
+            job = font_queue.front();
+            font_queue.pop_front();
+        }
+
+        if (job.type == BITMAP_ASSET)
+        {
+            ALLEGRO_BITMAP *bitmap = job.bitmap ? al_clone_bitmap(job.bitmap) : NULL;
+            if (bitmap)
+            {
+                al_destroy_bitmap(job.bitmap);
+            }
+            else
+            {
+                bitmap = job.bitmap;
+            }
+
+            if (!bitmap)
+            {
+                printf("Could not load bitmap %s\n", job.path.c_str());
+            }
+            finish_asset(BITMAP_ASSET, pending_bitmaps, job.name, weak_bitmaps, &prefetched_bitmaps,
+                         bitmap ? make_shared_bitmap(bitmap) : shared_bitmap());
+        }
+        else if (job.type == FONT_ASSET)
+        {
+            ALLEGRO_FONT *font = load_font_file(job.path, job.size);
+            if (!font)
+            {
+                printf("Could not load font %s\n", job.path.c_str());
+            }
+            finish_asset(FONT_ASSET, pending_fonts, job.name, weak_fonts,
+                         (unordered_map<string, shared_font> *)NULL,
+                         font ? make_shared_font(font) : shared_font());
+        }
+        else
+        {
+            if (!job.sample)
+            {
+                printf("Could not load sample %s\n", job.path.c_str());
+            }
+            finish_asset(SAMPLE_ASSET, pending_samples, job.name, weak_samples, &prefetched_samples,
+                         job.sample ? make_shared_sample(job.sample) : shared_sample());
+        }
+    }
+}
+
+/*******************************************************************************
+Stops the loader thread, frees whatever it decoded that was never finished, and
+makes every pending future ready with NULL.
+*******************************************************************************/
+void stop_loading()
+{
+    if (asset_loader.joinable())
+    {
+        loader_mutex.lock();
+        loader_stopping = true;
+        loader_mutex.unlock();
+        loader_wake.notify_all();
+        asset_loader.join();
+    }
+
+    for (size_t i = 0; i < decoded_queue.size(); i++)
+    {
+        if (decoded_queue[i].bitmap)
+        {
+            al_destroy_bitmap(decoded_queue[i].bitmap);
+        }
+        if (decoded_queue[i].sample)
+        {
+            al_destroy_sample(decoded_queue[i].sample);
+        }
+    }
+    load_queue.clear();
+    decoded_queue.clear();
+    font_queue.clear();
+
+    for (auto it = pending_bitmaps.begin(); it != pending_bitmaps.end(); ++it)
+    {
+        it->second.loaded.set_value(shared_bitmap());
+    }
+    for (auto it = pending_fonts.begin(); it != pending_fonts.end(); ++it)
+    {
+        it->second.loaded.set_value(shared_font());
+    }
+    for (auto it = pending_samples.begin(); it != pending_samples.end(); ++it)
+    {
+        it->second.loaded.set_value(shared_sample());
+    }
+    pending_bitmaps.clear();
+    pending_fonts.clear();
+    pending_samples.clear();
+    prefetched_bitmaps.clear();
+    prefetched_samples.clear();
+}
+
 /***************************************************************************//**
 @ingroup assets_group
 Goes through each urgent and facile table to erase each entry. Should be called
@@ -398,6 +1245,12 @@ after game loop ends. The game will crash on exit if this isn't called.
 *******************************************************************************/
 void unload_assets()
 {
+    stop_loading();
+    retained_assets.clear();
+    bitmap_handles = HandleTable<shared_bitmap>();
+    font_handles = HandleTable<shared_font>();
+    sample_handles = HandleTable<shared_sample>();
+
     for (auto it = urgent_bitmaps.begin(); it != urgent_bitmaps.end();)
     {
         it = urgent_bitmaps.erase(it);
@@ -443,13 +1296,15 @@ A good naming convention to consider when loading bitmaps may be to name the
 bitmap as its filename minus the extension.
 This function's job is to load a new entry into facile_bitmaps. The two arguments
 it accepts are the name of an bitmap you may wish to load later, and the path to
-that bitmap.\n
+that bitmap. The bitmap itself isn't loaded; ::check_asset only makes sure it
+is there.\n
 A good naming convention to consider when loading bimaps may be to name the
 bitmap as its filename minus the extension.
 *******************************************************************************/
 void insert_urgent_bitmap(string name, string path)
 {
-    shared_bitmap bmp = make_shared_bitmap(al_load_bitmap(path.c_str()));
+    register_name(bitmap_handles, name);
+    shared_bitmap bmp = make_shared_bitmap(load_bitmap_file(path));
     if (!bmp)
     {
         printf("Could not find find bitmap %s\n", path.c_str());
@@ -459,8 +1314,8 @@ void insert_urgent_bitmap(string name, string path)
 
 void insert_facile_bitmap(string name, string path)
 {
-    shared_bitmap bmp = make_shared_bitmap(al_load_bitmap(path.c_str()));
-    if (!bmp)
+    register_name(bitmap_handles, name);
+    if (!check_asset(path, "bitmap"))
     {
         printf("Could not find find bitmap %s\n", path.c_str());
     }
@@ -485,7 +1340,8 @@ when it is looked up using find_font(string name).
 *******************************************************************************/
 void insert_urgent_font(string name, string path, int size)
 {
-    shared_font f = make_shared_font(al_load_font(path.c_str(), size, 0));
+    register_name(font_handles, name);
+    shared_font f = make_shared_font(load_font_file(path, size));
     if (!f)
     {
         printf("Could not find find font %s\n", path.c_str());
@@ -495,8 +1351,8 @@ void insert_urgent_font(string name, string path, int size)
 
 void insert_facile_font(string name, string path)
 {
-    shared_font font = make_shared_font(al_load_font(path.c_str(), 8, 0));
-    if (!font)
+    register_name(font_handles, name);
+    if (!check_asset(path, "font"))
     {
         printf("Could not find find font %s\n", path.c_str());
     }
@@ -517,7 +1373,8 @@ them as their filename minus the extension.
 *******************************************************************************/
 void insert_urgent_sample(string name, string path)
 {
-    shared_sample s = make_shared_sample(al_load_sample(path.c_str()));
+    register_name(sample_handles, name);
+    shared_sample s = make_shared_sample(load_sample_file(path));
     if (!s)
     {
         printf("Could not find find sample %s\n", path.c_str());
@@ -527,10 +1384,125 @@ void insert_urgent_sample(string name, string path)
 
 void insert_facile_sample(string name, string path)
 {
-    shared_sample sample = make_shared_sample(al_load_sample(path.c_str()));
-    if (!sample)
+    register_name(sample_handles, name);
+    if (!check_asset(path, "sample"))
     {
         printf("Could not find find sample %s\n", path.c_str());
     }
     facile_samples.insert(pair<string, string>(name, path));
 }
+
+/*******************************************************************************
+Atlas pages. Pages are ATLAS_PAGE_SIZE square, or as large as the display
+allows if that is smaller. A bitmap covering more than ATLAS_MAX_FRACTION of a
+page is left alone, as it would leave little room for anything else. Packed
+bitmaps are kept ATLAS_PADDING transparent pixels apart, so filtering at the
+edge of one doesn't pick up its neighbour.
+*******************************************************************************/
+const int ATLAS_PAGE_SIZE = 2048;
+const double ATLAS_MAX_FRACTION = 0.5;
+const int ATLAS_PADDING = 1;
+
+struct AtlasPage
+{
+    AtlasPacker packer;
+    shared_bitmap bitmap;
+};
+
+/***************************************************************************//**
+@fn void pack_urgent_bitmaps()
+@ingroup assets_group
+Copies the bitmaps of ::urgent_bitmaps that fit into atlas pages, tallest
+first, using ::AtlasPacker, and replaces each with a sub-bitmap of its page. A
+sub-bitmap holds on to its page, so a page lives as long as any bitmap packed
+into it. Bitmaps that are too large, or that are already sub-bitmaps, are left
+as they are.
+*******************************************************************************/
+void pack_urgent_bitmaps()
+{
+    int page_size = ATLAS_PAGE_SIZE;
+    if (ALLEGRO_DISPLAY *display = al_get_current_display())
+    {
+        page_size = min(page_size, al_get_display_option(display, ALLEGRO_MAX_BITMAP_SIZE));
+    }
+
+    vector<pair<string, shared_bitmap> > candidates;
+    for (auto it = urgent_bitmaps.begin(); it != urgent_bitmaps.end(); it++)
+    {
+        ALLEGRO_BITMAP *bitmap = it->second.get();
+        if (!bitmap || al_is_sub_bitmap(bitmap))
+        {
+            continue;
+        }
+
+        int width = al_get_bitmap_width(bitmap);
+        int height = al_get_bitmap_height(bitmap);
+        if (width + ATLAS_PADDING <= page_size && height + ATLAS_PADDING <= page_size
+            && (double)width * height <= ATLAS_MAX_FRACTION * page_size * page_size)
+        {
+            candidates.push_back(*it);
+        }
+    }
+
+    sort(candidates.begin(), candidates.end(),
+         [](const pair<string, shared_bitmap> &a, const pair<string, shared_bitmap> &b) {
+             int a_height = al_get_bitmap_height(a.second.get());
+             int b_height = al_get_bitmap_height(b.second.get());
+             if (a_height != b_height)
+             {
+                 return a_height > b_height;
+             }
+             int a_width = al_get_bitmap_width(a.second.get());
+             int b_width = al_get_bitmap_width(b.second.get());
+             return a_width != b_width ? a_width > b_width : a.first < b.first;
+         });
+
+    ALLEGRO_BITMAP *target = al_get_target_bitmap();
+    vector<AtlasPage> pages;
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        ALLEGRO_BITMAP *source = candidates[i].second.get();
+        int width = al_get_bitmap_width(source);
+        int height = al_get_bitmap_height(source);
+
+        int x = 0, y = 0;
+        size_t page = 0;
+        while (page < pages.size()
+               && !pages[page].packer.insert(width + ATLAS_PADDING, height + ATLAS_PADDING, x, y))
+        {
+            page++;
+        }
+
+        if (page == pages.size())
+        {
+            AtlasPage fresh = { AtlasPacker(page_size, page_size),
+                                make_shared_bitmap(al_create_bitmap(page_size, page_size)) };
+            if (!fresh.bitmap || !fresh.packer.insert(width + ATLAS_PADDING, height + ATLAS_PADDING, x, y))
+            {
+                continue;
+            }
+            al_set_target_bitmap(fresh.bitmap.get());
+            al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+            pages.push_back(fresh);
+        }
+
+        shared_bitmap atlas = pages[page].bitmap;
+        al_set_target_bitmap(atlas.get());
+        al_draw_bitmap(source, x, y, 0);
+
+        ALLEGRO_BITMAP *sub = al_create_sub_bitmap(atlas.get(), x, y, width, height);
+        if (sub)
+        {
+            urgent_bitmaps[candidates[i].first] = shared_bitmap(sub, [atlas](ALLEGRO_BITMAP *bitmap) {
+                al_destroy_bitmap(bitmap);
+            });
+        }
+    }
+    al_set_target_bitmap(target);
+
+    // Slots may still hold the bitmaps that were packed
+    for (size_t i = 0; i < bitmap_handles.slots.size(); i++)
+    {
+        bitmap_handles.slots[i].urgent.reset();
+    }
+}
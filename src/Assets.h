@@ -12,12 +12,16 @@ The submodule Asset Tables Group details how assets are stored at a lower level.
 @{
 *******************************************************************************/
 #pragma once
+#include "AssetCache.h"
 #include <allegro5/allegro.h>
 #include <allegro5/allegro_font.h>
 #include <allegro5/allegro_ttf.h>
 #include <allegro5/allegro_image.h>
 #include <allegro5/allegro_audio.h>
 #include <allegro5/allegro_acodec.h>
+#include <chrono>
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <string>
 
@@ -47,25 +51,132 @@ shared_font make_shared_font(ALLEGRO_FONT *font);
 shared_sample make_shared_sample(ALLEGRO_SAMPLE *sample);
 
 /*******************************************************************************
-@fn shared_bitmap find_bitmap(std::string name)
+@fn shared_bitmap find_bitmap(const std::string &name)
 Returns a shared bitmap from one of the bitmap tables whose name matches the
 string argument. Returns NULL if not found.
-@fn shared_font find_font(std::string name)
+@fn shared_font find_font(const std::string &name)
 Searches for a font in the urgent_font table whose name matches the string
 argument. This font will have a pre-determined size. Returns NULL if not 
 found.
-@fn shared_font find_font(std::string name, int size)
+@fn shared_font find_font(const std::string &name, int size)
 Searches for a font in the facile_font table whose name matches the string
 argument. This font will be loaded into memory from disk at the specified
 size. Returns NULL if not found.
-@fn shared_sample find_sample(std::string name)
+@fn shared_sample find_sample(const std::string &name)
 Searches for a sample in the sample tables whose name matches the string
 argument. Returns NULL if not found.
 *******************************************************************************/
-shared_bitmap find_bitmap(std::string name);
-shared_font find_font(std::string name);
-shared_font find_font(std::string name, int size);
-shared_sample find_sample(std::string name);
+shared_bitmap find_bitmap(const std::string &name);
+shared_font find_font(const std::string &name);
+shared_font find_font(const std::string &name, int size);
+shared_sample find_sample(const std::string &name);
+
+/*******************************************************************************
+@typedef AssetId
+A hash of an asset's name, computed at compile time by ::asset_id.
+@fn constexpr AssetId asset_id(const char *name, AssetId hash)
+Returns the ID of the asset called name: 32 bit FNV-1a over its characters.
+Leave hash out. Two names with the same ID are reported when the second is
+inserted, and only the first can be found by ID.
+@typedef asset_handle
+Index of an asset in a dense table, for lookups that don't hash anything. -1
+stands for no asset.
+*******************************************************************************/
+typedef uint32_t AssetId;
+typedef int asset_handle;
+
+constexpr AssetId asset_id(const char *name, AssetId hash = 2166136261u)
+{
+    return *name ? asset_id(name + 1, (hash ^ (unsigned char)*name) * 16777619u) : hash;
+}
+
+/*******************************************************************************
+@fn asset_handle bitmap_handle(AssetId id)
+Returns the handle of the bitmap with ID id, or -1 if no bitmap inserted by
+::load_bitmaps has it. Resolve a handle once, for example when a class is
+first constructed, and keep it:
+\verbatim
+static const asset_handle ELF_WALK = bitmap_handle(asset_id("elf_walk"));
+animation = new Animation(find_bitmap(ELF_WALK), 10, 9);
+\endverbatim
+@fn asset_handle font_handle(AssetId id)
+Returns the handle of the urgent font with ID id, as found by
+find_font(const std::string &name).
+@fn asset_handle font_handle(AssetId id, int size)
+Returns the handle of the facile font with ID id at size, as found by
+find_font(const std::string &name, int size).
+@fn asset_handle sample_handle(AssetId id)
+Returns the handle of the sample with ID id.
+@fn shared_bitmap find_bitmap(asset_handle handle)
+Same as ::find_bitmap by name, but the bitmap is found by indexing an array. Only
+the first lookup of an asset, and any after its last user let go of it, go
+through the name. Returns NULL for an invalid handle.
+@fn shared_font find_font(asset_handle handle)
+Same as find_bitmap(asset_handle handle), for fonts.
+@fn shared_sample find_sample(asset_handle handle)
+Same as find_bitmap(asset_handle handle), for samples.
+*******************************************************************************/
+asset_handle bitmap_handle(AssetId id);
+asset_handle font_handle(AssetId id);
+asset_handle font_handle(AssetId id, int size);
+asset_handle sample_handle(AssetId id);
+
+shared_bitmap find_bitmap(asset_handle handle);
+shared_font find_font(asset_handle handle);
+shared_sample find_sample(asset_handle handle);
+
+/*******************************************************************************
+@fn bitmap_future find_bitmap_async(std::string name)
+Same as ::find_bitmap, but returns straight away. A bitmap that has to come
+from disk is decoded on a loader thread and uploaded to the GPU by
+::update_assets; until then the future is not ready. Use ::is_ready to check it
+without blocking, and get() once it is. Asking again for a bitmap already on
+its way returns the same future.
+@fn font_future find_font_async(std::string name, int size)
+Same as find_font(std::string name, int size), but returns straight away. Fonts
+are loaded by ::update_assets on the game thread, since their glyphs are drawn
+into video bitmaps.
+@fn sample_future find_sample_async(std::string name)
+Same as ::find_sample, but returns straight away. Samples are decoded on the
+loader thread.
+@fn void prefetch(std::string name)
+Starts loading the facile bitmap and sample called name in the background, if
+there are any, so a ::State can warm the assets it is about to need. A
+prefetched asset is kept in memory until it is first looked up.
+@fn void update_assets(double budget)
+Finishes background loads: uploads decoded bitmaps, loads fonts and makes the
+futures ready, until budget seconds have passed, always finishing at least one.
+::update_game calls this every game cycle.
+@fn bool is_ready(const std::shared_future<Asset> &future)
+Returns true if future holds its asset, without waiting.
+*******************************************************************************/
+typedef std::shared_future<shared_bitmap> bitmap_future;
+typedef std::shared_future<shared_font> font_future;
+typedef std::shared_future<shared_sample> sample_future;
+
+bitmap_future find_bitmap_async(std::string name);
+font_future find_font_async(std::string name, int size);
+sample_future find_sample_async(std::string name);
+void prefetch(std::string name);
+void update_assets(double budget = 0.002);
+
+template <class Asset>
+bool is_ready(const std::shared_future<Asset> &future)
+{
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+/*******************************************************************************
+@fn void set_asset_budget(size_t bytes)
+Sets how many bytes of facile assets are kept in memory after the game stops
+using them; 64 MB by default. Assets past the budget are dropped least
+recently used first, and 0 keeps nothing.
+@fn const AssetCache &get_asset_cache()
+Returns the cache retaining facile assets, whose getHits, getMisses and
+getEvictions tell how well the budget fits the game.
+*******************************************************************************/
+void set_asset_budget(size_t bytes);
+const AssetCache &get_asset_cache();
 
 /*******************************************************************************
 @fn void load_bitmaps()
@@ -74,11 +185,18 @@ All bitmaps you plan on using in your game should be loaded in this function.
 All fonts you plan on using in your game should be loaded in this function.
 @fn void load_samples()
 All samples you plan on using in your game should be loaded in this function.
+@fn void pack_urgent_bitmaps()
+Gathers the urgent bitmaps that fit into shared atlas pages, so drawing them
+doesn't switch textures. Call it once, after ::load_bitmaps; ::find_bitmap then
+returns sub-bitmaps, which draw like any other bitmap.
 @fn void unload_assets()
 Properly destroys all assets in the tables. Should be called after game loop
-ends. Game will crash at exit if this isn't called.
+ends. Game will crash at exit if this isn't called. Also stops the loader
+thread; futures still pending are made ready with NULL. Asset handles are
+invalid afterwards.
 *******************************************************************************/
 void load_bitmaps();
 void load_fonts();
 void load_samples();
+void pack_urgent_bitmaps();
 void unload_assets();
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "AtlasPacker.h"
+#include <algorithm>
+#include <climits>
+
+AtlasPacker::AtlasPacker(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    used_area = 0;
+
+    Segment floor = { 0, 0, width };
+    skyline.push_back(floor);
+}
+
+/*******************************************************************************
+Returns the y a rect_width wide rectangle would rest at with its left edge on
+the segment at index, or -1 if it would run off the page.
+*******************************************************************************/
+int AtlasPacker::fit(size_t index, int rect_width, int rect_height) const
+{
+    int x = skyline[index].x;
+    if (x + rect_width > width)
+    {
+        return -1;
+    }
+
+    int y = 0;
+    int remaining = rect_width;
+    for (size_t i = index; remaining > 0; i++)
+    {
+        y = std::max(y, skyline[i].y);
+        remaining -= skyline[i].width;
+    }
+
+    return y + rect_height <= height ? y : -1;
+}
+
+bool AtlasPacker::insert(int rect_width, int rect_height, int &x, int &y)
+{
+    if (rect_width <= 0 || rect_height <= 0)
+    {
+        return false;
+    }
+
+    int best = -1, best_top = INT_MAX, best_y = 0;
+    for (size_t i = 0; i < skyline.size(); i++)
+    {
+        int rest = fit(i, rect_width, rect_height);
+        if (rest >= 0 && rest + rect_height < best_top)
+        {
+            best = i;
+            best_top = rest + rect_height;
+            best_y = rest;
+        }
+    }
+
+    if (best < 0)
+    {
+        return false;
+    }
+
+    x = skyline[best].x;
+    y = best_y;
+    used_area += (long long)rect_width * rect_height;
+
+    // The rectangle's top becomes a new segment, covering whatever it spans
+    Segment top = { x, best_top, rect_width };
+    skyline.insert(skyline.begin() + best, top);
+    size_t i = best + 1;
+    while (i < skyline.size() && skyline[i].x < top.x + top.width)
+    {
+        int covered = top.x + top.width - skyline[i].x;
+        if (covered < skyline[i].width)
+        {
+            skyline[i].x += covered;
+            skyline[i].width -= covered;
+            break;
+        }
+        skyline.erase(skyline.begin() + i);
+    }
+
+    // Neighbours at the same height are one segment
+    for (size_t j = 0; j + 1 < skyline.size();)
+    {
+        if (skyline[j].y == skyline[j + 1].y)
+        {
+            skyline[j].width += skyline[j + 1].width;
+            skyline.erase(skyline.begin() + j + 1);
+        }
+        else
+        {
+            j++;
+        }
+    }
+
+    return true;
+}
+
+double AtlasPacker::getOccupancy() const
+{
+    return (double)used_area / ((long long)width * height);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/***************************************************************************//**
+AtlasPacker places rectangles on a fixed size page without overlap, for
+gathering many small bitmaps into one texture. It keeps a skyline: the top
+edge of everything placed so far, as a list of horizontal segments from left to
+right. A new rectangle goes where its top ends up lowest, and leftmost on a
+tie, resting on the highest segment it spans. Space hidden under an overhang is
+given up, which costs little when rectangles are inserted tallest first.\n
+AtlasPacker only does the arithmetic; Assets draws the bitmaps.
+*******************************************************************************/
+class AtlasPacker
+{
+    public:
+/***************************************************************************//**
+@fn AtlasPacker(int width, int height)
+Creates an empty page of the given size.
+*******************************************************************************/
+        AtlasPacker(int width, int height);
+
+/***************************************************************************//**
+@fn bool insert(int width, int height, int &x, int &y)
+Finds room for a width by height rectangle and sets x and y to its top left
+corner. Returns false, leaving the page unchanged, if it doesn't fit.
+*******************************************************************************/
+        bool insert(int width, int height, int &x, int &y);
+
+/***************************************************************************//**
+@fn int getWidth() const
+@fn int getHeight() const
+Return the size of the page.
+@fn double getOccupancy() const
+Returns the fraction of the page covered by rectangles.
+*******************************************************************************/
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+        double getOccupancy() const;
+
+    private:
+        struct Segment {
+            int x, y, width;
+        };
+
+        int fit(size_t index, int rect_width, int rect_height) const;
+
+        std::vector<Segment> skyline;
+        int width;
+        int height;
+        long long used_area;
+};
@@ -1,4 +1,5 @@
 #include "Barrier.h"
+#include <cstddef>
 
 
 Barrier::Barrier(Body body) :
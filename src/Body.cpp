@@ -99,18 +99,16 @@ void Body::setDFric(float d)
 }
 
 /***********************************************************************//**
-Calculates new acceleration based on this mass and the compelling_forces.
-Updates velocity based on acceleration, position based on velocity, then
-resets compelling_forces to 0.
+Calculates the change in velocity caused by compelling_forces, and updates
+velocity based on acceleration over dt and position based on velocity over dt.
+Then resets compelling_forces to 0.
 ***************************************************************************/
-void Body::update()
+void Body::update(float dt)
 {
-    Vector3 da = compelling_forces * (1 / getMass()) * !is_static;
-    acceleration = acceleration + da;
-    velocity = getVel() + getAccel();
-    position = position + velocity;
+    Vector3 dv = compelling_forces * (1 / getMass()) * !is_static;
+    velocity = getVel() + getAccel() * dt + dv;
+    position = position + velocity * dt;
 
-    acceleration = acceleration - da;
     compelling_forces = Vector3(0, 0, 0);
 }
 
@@ -140,7 +140,14 @@ class Body
 
         void applyForce(Vector3 force) { compelling_forces = (compelling_forces + force) * !is_static; }
 
-        void update();
+/***************************************************************************//**
+@fn void update(float dt = 1)
+Integrates this body over \p dt game cycles. Forces applied since the last
+update are treated as impulses that were each applied for one cycle, so a
+body updated every few cycles ends up where it would have been had it been
+updated every cycle.
+*******************************************************************************/
+        void update(float dt = 1);
 
         bool checkCollision(const Body object) const;
 
@@ -1,4 +1,5 @@
 #include "Character.h"
+#include "Animation.h"
 #include "Keyboard.h"
 #include "Globals.h"
 
@@ -24,7 +25,8 @@ Character::Character() :
     32, 32
     )
 {
-    animation = new Animation(find_bitmap("elf_walk"), 10, 9);
+    static const asset_handle elf_walk = bitmap_handle(asset_id("elf_walk"));
+    animation = new Animation(find_bitmap(elf_walk), 10, 9);
     setActiveAnimation(animation);
 }
 
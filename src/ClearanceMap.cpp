@@ -0,0 +1,118 @@
+#include "ClearanceMap.h"
+#include "Mesh.h"
+#include <algorithm>
+
+void ClearanceMap::build(const Mesh &mesh)
+{
+    clearance.assign(mesh.length * mesh.thickness, 0);
+    update(mesh, 0, 0, mesh.length, mesh.thickness);
+}
+
+/*******************************************************************************
+A change batch is usually one object moving, so the nodes changed sit close
+together and one window around all of them is barely larger than needed.
+*******************************************************************************/
+void ClearanceMap::markChanged(const Mesh &mesh, const frame_vector<int> &nodes)
+{
+    if (!isBuilt() || nodes.empty())
+    {
+        return;
+    }
+
+    int x0 = mesh.length, y0 = mesh.thickness, x1 = 0, y1 = 0;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        int x = nodes[i] % mesh.length;
+        int y = nodes[i] / mesh.length;
+        x0 = std::min(x0, x);
+        y0 = std::min(y0, y);
+        x1 = std::max(x1, x + 1);
+        y1 = std::max(y1, y + 1);
+    }
+
+    update(mesh, std::max(x0 - MAX_CLEARANCE, 0), std::max(y0 - MAX_CLEARANCE, 0),
+           std::min(x1 + MAX_CLEARANCE, mesh.length), std::min(y1 + MAX_CLEARANCE, mesh.thickness));
+}
+
+/*******************************************************************************
+Recalculates the nodes from (x0, y0) up to but not including (x1, y1). Only
+objects within MAX_CLEARANCE of those nodes can matter, and the shortest chain
+of steps to any of them stays inside the box around both, so the passes are run
+over the region grown by MAX_CLEARANCE on every side and only the middle is
+copied back.
+*******************************************************************************/
+void ClearanceMap::update(const Mesh &mesh, int x0, int y0, int x1, int y1)
+{
+    int wx0 = std::max(x0 - MAX_CLEARANCE, 0);
+    int wy0 = std::max(y0 - MAX_CLEARANCE, 0);
+    int wx1 = std::min(x1 + MAX_CLEARANCE, mesh.length);
+    int wy1 = std::min(y1 + MAX_CLEARANCE, mesh.thickness);
+    int width = wx1 - wx0;
+    int rows = wy1 - wy0;
+
+    window.resize(width * rows);
+    for (int y = 0; y < rows; y++)
+    {
+        unsigned char *row = &window[y * width];
+        for (int x = 0; x < width; x++)
+        {
+            row[x] = mesh.isBlocked(mesh.toIndex(wx0 + x, wy0 + y)) ? 0 : MAX_CLEARANCE;
+        }
+    }
+
+    // Downwards: neighbors above, then the one to the left
+    for (int y = 0; y < rows; y++)
+    {
+        unsigned char *row = &window[y * width];
+        if (y > 0)
+        {
+            const unsigned char *above = row - width;
+            row[0] = std::min<unsigned char>(row[0], std::min(above[0], above[std::min(1, width - 1)]) + 1);
+            for (int x = 1; x < width - 1; x++)
+            {
+                unsigned char nearest = std::min(std::min(above[x - 1], above[x]), above[x + 1]);
+                row[x] = std::min<unsigned char>(row[x], nearest + 1);
+            }
+            if (width > 1)
+            {
+                row[width - 1] = std::min<unsigned char>(row[width - 1],
+                                                         std::min(above[width - 2], above[width - 1]) + 1);
+            }
+        }
+        for (int x = 1; x < width; x++)
+        {
+            row[x] = std::min<unsigned char>(row[x], row[x - 1] + 1);
+        }
+    }
+
+    // Upwards: neighbors below, then the one to the right
+    for (int y = rows - 1; y >= 0; y--)
+    {
+        unsigned char *row = &window[y * width];
+        if (y < rows - 1)
+        {
+            const unsigned char *below = row + width;
+            row[0] = std::min<unsigned char>(row[0], std::min(below[0], below[std::min(1, width - 1)]) + 1);
+            for (int x = 1; x < width - 1; x++)
+            {
+                unsigned char nearest = std::min(std::min(below[x - 1], below[x]), below[x + 1]);
+                row[x] = std::min<unsigned char>(row[x], nearest + 1);
+            }
+            if (width > 1)
+            {
+                row[width - 1] = std::min<unsigned char>(row[width - 1],
+                                                         std::min(below[width - 2], below[width - 1]) + 1);
+            }
+        }
+        for (int x = width - 2; x >= 0; x--)
+        {
+            row[x] = std::min<unsigned char>(row[x], row[x + 1] + 1);
+        }
+    }
+
+    for (int y = y0; y < y1; y++)
+    {
+        const unsigned char *row = &window[(y - wy0) * width + (x0 - wx0)];
+        std::copy(row, row + (x1 - x0), clearance.begin() + mesh.toIndex(x0, y));
+    }
+}
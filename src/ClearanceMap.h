@@ -0,0 +1,55 @@
+#pragma once
+#include "FrameArena.h"
+#include <vector>
+
+class Mesh;
+
+/***************************************************************************//**
+ClearanceMap stores, for every node of a ::Mesh, how far it is from the nearest
+node covered by an object: 0 on such a node, 1 right next to one, and so on,
+counting diagonal steps as 1. Values stop growing at MAX_CLEARANCE. A search
+for an agent wider than one node only walks nodes with enough clearance for
+its radius, so it is never sent through a gap it can't fit through.\n
+The map is filled with two passes over the mesh, one top to bottom and one
+back up, each taking the smaller of a node's own value and its already visited
+neighbors' plus one. Each pass does a row at a time: the step from the row
+before is a plain loop the compiler can vectorize, only the step along the row
+is serial. Because values are capped, a change can only affect nodes within
+MAX_CLEARANCE of it, so when objects are inserted or cleared only that window
+is recalculated.\n
+ClearanceMap only stores plain data; every method is handed the mesh it
+describes.
+*******************************************************************************/
+class ClearanceMap
+{
+    public:
+/***************************************************************************//**
+@var MAX_CLEARANCE
+Largest clearance stored. Agents needing more are treated as needing this
+much.
+*******************************************************************************/
+        static const int MAX_CLEARANCE = 8;
+
+/***************************************************************************//**
+@fn void build(const Mesh &mesh)
+Calculates the clearance of every node.
+@fn bool isBuilt() const
+Returns true once build has been called.
+@fn void markChanged(const Mesh &mesh, const frame_vector<int> &nodes)
+Call after nodes became blocked or free; recalculates the nodes near them.
+@fn int get(int node) const
+Returns the clearance of node.
+*******************************************************************************/
+        void build(const Mesh &mesh);
+        bool isBuilt() const { return !clearance.empty(); }
+        void markChanged(const Mesh &mesh, const frame_vector<int> &nodes);
+        int get(int node) const { return clearance[node]; }
+
+    private:
+        friend class Mesh;
+
+        void update(const Mesh &mesh, int x0, int y0, int x1, int y1);
+
+        std::vector<unsigned char> clearance;
+        std::vector<unsigned char> window; // Scratch for update
+};
@@ -0,0 +1,593 @@
+#include "Crowd.h"
+#include <algorithm>
+#include <cmath>
+using std::vector;
+
+// Agents handed out to a thread at a time
+static const int CHUNK = 64;
+static const float EPSILON = 0.00001f;
+// Grid cells across the neighbor distance
+static const float CELLS_PER_DISTANCE = 4;
+// Cap on grid cells per side, so a few agents far apart don't make a huge grid
+static const int MAX_CELLS = 1024;
+
+static float det(float ax, float ay, float bx, float by)
+{
+    return ax * by - ay * bx;
+}
+
+Crowd::Crowd(int num_threads)
+{
+    num_agents = 0;
+    time_horizon = 60;
+    neighbor_distance = 300;
+    max_neighbors = 10;
+    min_x = min_y = 0;
+    cell_size = 1;
+    cells_x = cells_y = 0;
+    next_state = 0;
+    round = 0;
+    busy = 0;
+    stopping = false;
+
+    scratch.resize(num_threads + 1);
+    for (int i = 0; i < num_threads; i++)
+    {
+        workers.push_back(std::thread(&Crowd::work, this, i + 1));
+    }
+}
+
+Crowd::~Crowd()
+{
+    mtx.lock();
+    stopping = true;
+    mtx.unlock();
+    wake.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+}
+
+int Crowd::add(GameObject *object, float radius, float max_speed)
+{
+    Agent agent;
+    agent.object = object;
+    agent.radius = radius;
+    agent.max_speed = max_speed;
+    agent.pref_x = agent.pref_y = 0;
+    agent.vx = agent.vy = 0;
+    num_agents++;
+
+    if (free_agents.empty())
+    {
+        agents.push_back(agent);
+        return agents.size() - 1;
+    }
+
+    int handle = free_agents.back();
+    free_agents.pop_back();
+    agents[handle] = agent;
+    return handle;
+}
+
+void Crowd::remove(int agent)
+{
+    agents[agent].object = NULL;
+    free_agents.push_back(agent);
+    num_agents--;
+}
+
+void Crowd::setPreferredVelocity(int agent, Vector3 velocity)
+{
+    Agent &a = agents[agent];
+    a.pref_x = velocity.x;
+    a.pref_y = velocity.y;
+    if (!a.object)
+    {
+        return;
+    }
+
+    // Keep within the agent's speed
+    float speed = sqrtf(a.pref_x * a.pref_x + a.pref_y * a.pref_y);
+    if (speed > a.max_speed)
+    {
+        a.pref_x *= a.max_speed / speed;
+        a.pref_y *= a.max_speed / speed;
+    }
+}
+
+void Crowd::update()
+{
+    states.clear();
+    state_agent.clear();
+    for (size_t i = 0; i < agents.size(); i++)
+    {
+        const Agent &agent = agents[i];
+        if (!agent.object)
+        {
+            continue;
+        }
+
+        State state;
+        state.x = agent.object->getPosX();
+        state.y = agent.object->getPosY();
+        state.vx = agent.object->getVelX();
+        state.vy = agent.object->getVelY();
+        state.radius = agent.radius;
+        state.max_speed = agent.max_speed;
+        state.pref_x = agent.pref_x;
+        state.pref_y = agent.pref_y;
+        states.push_back(state);
+        state_agent.push_back(i);
+    }
+
+    if (states.empty())
+    {
+        return;
+    }
+
+    buildGrid();
+
+    next_state = 0;
+    if (workers.empty())
+    {
+        solveShare(scratch[0]);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mtx);
+    round++;
+    busy = workers.size();
+    lock.unlock();
+    wake.notify_all();
+
+    solveShare(scratch[0]);
+
+    lock.lock();
+    finished.wait(lock, [this] { return busy == 0; });
+}
+
+int Crowd::cellOf(const State &state) const
+{
+    int cx = std::min((int)((state.x - min_x) / cell_size), cells_x - 1);
+    int cy = std::min((int)((state.y - min_y) / cell_size), cells_y - 1);
+    return cy * cells_x + cx;
+}
+
+/*******************************************************************************
+Buckets the states by cell with a counting sort. The grid covers just the
+agents, with CELLS_PER_DISTANCE cells across the neighbor distance, or fewer
+if the grid had to be capped.
+*******************************************************************************/
+void Crowd::buildGrid()
+{
+    float max_x = min_x = states[0].x;
+    float max_y = min_y = states[0].y;
+    for (size_t i = 1; i < states.size(); i++)
+    {
+        min_x = std::min(min_x, states[i].x);
+        min_y = std::min(min_y, states[i].y);
+        max_x = std::max(max_x, states[i].x);
+        max_y = std::max(max_y, states[i].y);
+    }
+
+    cell_size = std::max(neighbor_distance / CELLS_PER_DISTANCE, 1.0f);
+    cell_size = std::max(cell_size, (max_x - min_x) / (MAX_CELLS - 1));
+    cell_size = std::max(cell_size, (max_y - min_y) / (MAX_CELLS - 1));
+    cells_x = std::min((int)((max_x - min_x) / cell_size) + 1, MAX_CELLS);
+    cells_y = std::min((int)((max_y - min_y) / cell_size) + 1, MAX_CELLS);
+
+    // Count each cell, turn the counts into the end of each cell's range, then
+    // drop every state in from the end, leaving cell_start at the range's start
+    int num_cells = cells_x * cells_y;
+    cell_start.assign(num_cells + 1, 0);
+    cell_states.resize(states.size());
+    for (size_t i = 0; i < states.size(); i++)
+    {
+        cell_start[cellOf(states[i])]++;
+    }
+
+    for (int i = 1; i < num_cells; i++)
+    {
+        cell_start[i] += cell_start[i - 1];
+    }
+    cell_start[num_cells] = states.size();
+
+    for (int i = states.size() - 1; i >= 0; i--)
+    {
+        cell_states[--cell_start[cellOf(states[i])]] = i;
+    }
+}
+
+/*******************************************************************************
+Keeps the max_neighbors nearest states within the neighbor distance of state i
+in scratch.neighbors, nearest first. Cells are visited in square rings around
+the state's own, stopping once the list is full and the next ring is further
+away than everything in it, so packed crowds only look at a few cells.
+*******************************************************************************/
+void Crowd::findNeighbors(int i, Scratch &scratch) const
+{
+    const State &self = states[i];
+    float range_sq = neighbor_distance * neighbor_distance;
+    scratch.neighbors.clear();
+    if (max_neighbors <= 0)
+    {
+        return;
+    }
+
+    int cx = std::min((int)((self.x - min_x) / cell_size), cells_x - 1);
+    int cy = std::min((int)((self.y - min_y) / cell_size), cells_y - 1);
+    int rings = (int)ceilf(neighbor_distance / cell_size);
+
+    for (int ring = 0; ring <= rings; ring++)
+    {
+        // Every cell in this ring is at least this far from self
+        float gap = (ring - 1) * cell_size;
+        if (ring > 1 && gap * gap >= range_sq)
+        {
+            break;
+        }
+
+        for (int y = std::max(cy - ring, 0); y <= std::min(cy + ring, cells_y - 1); y++)
+        {
+            // Only the ring's edge: the two end columns, or the whole row on its
+            // top and bottom
+            bool edge = y == cy - ring || y == cy + ring;
+            int step = edge || ring == 0 ? 1 : 2 * ring;
+            for (int x = cx - ring; x <= cx + ring; x += step)
+            {
+                if (x < 0 || x >= cells_x)
+                {
+                    continue;
+                }
+
+                int cell = y * cells_x + x;
+                for (int k = cell_start[cell]; k < cell_start[cell + 1]; k++)
+                {
+                    int j = cell_states[k];
+                    float dx = states[j].x - self.x;
+                    float dy = states[j].y - self.y;
+                    float dist_sq = dx * dx + dy * dy;
+                    if (j == i || dist_sq >= range_sq)
+                    {
+                        continue;
+                    }
+
+                    // Insertion into the short sorted list
+                    if ((int)scratch.neighbors.size() < max_neighbors)
+                    {
+                        scratch.neighbors.push_back(std::make_pair(dist_sq, j));
+                    }
+                    else
+                    {
+                        scratch.neighbors.back() = std::make_pair(dist_sq, j);
+                    }
+
+                    for (size_t n = scratch.neighbors.size() - 1; n > 0
+                         && scratch.neighbors[n].first < scratch.neighbors[n - 1].first; n--)
+                    {
+                        std::swap(scratch.neighbors[n], scratch.neighbors[n - 1]);
+                    }
+
+                    if ((int)scratch.neighbors.size() == max_neighbors)
+                    {
+                        range_sq = scratch.neighbors.back().first;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+Builds one half-plane of allowed velocities per neighbor and picks the allowed
+velocity closest to the preferred one. Each half-plane splits the change needed
+to avoid the neighbor evenly between the two agents, which is what lets both
+move without the two of them swerving the same way.
+*******************************************************************************/
+void Crowd::solve(int i, Scratch &scratch)
+{
+    const State &self = states[i];
+    float inv_horizon = 1 / time_horizon;
+    findNeighbors(i, scratch);
+
+    scratch.lines.clear();
+    for (size_t n = 0; n < scratch.neighbors.size(); n++)
+    {
+        const State &other = states[scratch.neighbors[n].second];
+        float rel_x = other.x - self.x;
+        float rel_y = other.y - self.y;
+        float rel_vx = self.vx - other.vx;
+        float rel_vy = self.vy - other.vy;
+        float dist_sq = scratch.neighbors[n].first;
+        float radius = self.radius + other.radius;
+        float radius_sq = radius * radius;
+
+        Line line;
+        float ux, uy;
+        if (dist_sq > radius_sq)
+        {
+            // Velocity relative to the cut-off circle at the time horizon
+            float wx = rel_vx - inv_horizon * rel_x;
+            float wy = rel_vy - inv_horizon * rel_y;
+            float w_sq = wx * wx + wy * wy;
+            float dot = wx * rel_x + wy * rel_y;
+
+            if (dot < 0 && dot * dot > radius_sq * w_sq)
+            {
+                // Closest to the cut-off circle
+                float w_length = sqrtf(w_sq);
+                float unit_x = wx / w_length;
+                float unit_y = wy / w_length;
+                line.dx = unit_y;
+                line.dy = -unit_x;
+                ux = (radius * inv_horizon - w_length) * unit_x;
+                uy = (radius * inv_horizon - w_length) * unit_y;
+            }
+            else
+            {
+                // Closest to one of the legs of the cone
+                float leg = sqrtf(dist_sq - radius_sq);
+                if (det(rel_x, rel_y, wx, wy) > 0)
+                {
+                    line.dx = (rel_x * leg - rel_y * radius) / dist_sq;
+                    line.dy = (rel_x * radius + rel_y * leg) / dist_sq;
+                }
+                else
+                {
+                    line.dx = -(rel_x * leg + rel_y * radius) / dist_sq;
+                    line.dy = -(-rel_x * radius + rel_y * leg) / dist_sq;
+                }
+
+                float along = rel_vx * line.dx + rel_vy * line.dy;
+                ux = along * line.dx - rel_vx;
+                uy = along * line.dy - rel_vy;
+            }
+        }
+        else
+        {
+            // Already touching: get apart within one game cycle
+            float wx = rel_vx - rel_x;
+            float wy = rel_vy - rel_y;
+            float w_length = sqrtf(wx * wx + wy * wy);
+            float unit_x = w_length > EPSILON ? wx / w_length : 1;
+            float unit_y = w_length > EPSILON ? wy / w_length : 0;
+            line.dx = unit_y;
+            line.dy = -unit_x;
+            ux = (radius - w_length) * unit_x;
+            uy = (radius - w_length) * unit_y;
+        }
+
+        line.px = self.vx + 0.5f * ux;
+        line.py = self.vy + 0.5f * uy;
+        scratch.lines.push_back(line);
+    }
+
+    float result_x, result_y;
+    int failed = solveInCircle(scratch.lines, self.max_speed, self.pref_x, self.pref_y, false, result_x, result_y);
+    if (failed < (int)scratch.lines.size())
+    {
+        solveLeastPenetration(scratch.lines, failed, self.max_speed, scratch.projected, result_x, result_y);
+    }
+
+    Agent &agent = agents[state_agent[i]];
+    agent.vx = result_x;
+    agent.vy = result_y;
+}
+
+/*******************************************************************************
+Finds the point on lines[line], within radius of the origin and allowed by
+every line before it, that is closest to opt, or furthest along opt if
+direction is true. Returns false if there is none.
+*******************************************************************************/
+bool Crowd::solveOnLine(const vector<Line> &lines, int line, float radius, float opt_x, float opt_y,
+                        bool direction, float &result_x, float &result_y)
+{
+    const Line &l = lines[line];
+    float dot = l.px * l.dx + l.py * l.dy;
+    float discriminant = dot * dot + radius * radius - (l.px * l.px + l.py * l.py);
+    if (discriminant < 0)
+    {
+        return false;
+    }
+
+    float root = sqrtf(discriminant);
+    float t_left = -dot - root;
+    float t_right = -dot + root;
+
+    for (int i = 0; i < line; i++)
+    {
+        float denominator = det(l.dx, l.dy, lines[i].dx, lines[i].dy);
+        float numerator = det(lines[i].dx, lines[i].dy, l.px - lines[i].px, l.py - lines[i].py);
+
+        if (fabsf(denominator) <= EPSILON)
+        {
+            // Parallel lines
+            if (numerator < 0)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        float t = numerator / denominator;
+        if (denominator >= 0)
+        {
+            t_right = std::min(t_right, t);
+        }
+        else
+        {
+            t_left = std::max(t_left, t);
+        }
+
+        if (t_left > t_right)
+        {
+            return false;
+        }
+    }
+
+    float t;
+    if (direction)
+    {
+        t = opt_x * l.dx + opt_y * l.dy > 0 ? t_right : t_left;
+    }
+    else
+    {
+        t = l.dx * (opt_x - l.px) + l.dy * (opt_y - l.py);
+        t = std::max(t_left, std::min(t, t_right));
+    }
+
+    result_x = l.px + t * l.dx;
+    result_y = l.py + t * l.dy;
+    return true;
+}
+
+/*******************************************************************************
+Finds the velocity within radius of the origin, allowed by every line, that is
+closest to opt (or furthest along opt if direction is true), adding one line
+at a time and only moving the result when it breaks the new line. Returns the
+number of lines, or the first line that couldn't be met, in which case the
+result is the best one for the lines before it.
+*******************************************************************************/
+int Crowd::solveInCircle(const vector<Line> &lines, float radius, float opt_x, float opt_y,
+                         bool direction, float &result_x, float &result_y)
+{
+    float opt_sq = opt_x * opt_x + opt_y * opt_y;
+    if (direction)
+    {
+        result_x = opt_x * radius;
+        result_y = opt_y * radius;
+    }
+    else if (opt_sq > radius * radius)
+    {
+        float scale = radius / sqrtf(opt_sq);
+        result_x = opt_x * scale;
+        result_y = opt_y * scale;
+    }
+    else
+    {
+        result_x = opt_x;
+        result_y = opt_y;
+    }
+
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        if (det(lines[i].dx, lines[i].dy, lines[i].px - result_x, lines[i].py - result_y) > 0)
+        {
+            float old_x = result_x, old_y = result_y;
+            if (!solveOnLine(lines, i, radius, opt_x, opt_y, direction, result_x, result_y))
+            {
+                result_x = old_x;
+                result_y = old_y;
+                return i;
+            }
+        }
+    }
+
+    return lines.size();
+}
+
+/*******************************************************************************
+Called when the neighbors are too close for every line to be met: from line
+begin on, finds the velocity that breaks the worst line by as little as
+possible, by searching along the bisectors of each line with the ones before
+it.
+*******************************************************************************/
+void Crowd::solveLeastPenetration(const vector<Line> &lines, int begin, float radius,
+                                  vector<Line> &projected, float &result_x, float &result_y)
+{
+    float distance = 0;
+    for (size_t i = begin; i < lines.size(); i++)
+    {
+        const Line &l = lines[i];
+        if (det(l.dx, l.dy, l.px - result_x, l.py - result_y) <= distance)
+        {
+            continue;
+        }
+
+        projected.clear();
+        for (size_t j = 0; j < i; j++)
+        {
+            Line line;
+            float determinant = det(l.dx, l.dy, lines[j].dx, lines[j].dy);
+            if (fabsf(determinant) <= EPSILON)
+            {
+                if (l.dx * lines[j].dx + l.dy * lines[j].dy > 0)
+                {
+                    // Same direction; line j adds nothing
+                    continue;
+                }
+                line.px = 0.5f * (l.px + lines[j].px);
+                line.py = 0.5f * (l.py + lines[j].py);
+            }
+            else
+            {
+                float t = det(lines[j].dx, lines[j].dy, l.px - lines[j].px, l.py - lines[j].py) / determinant;
+                line.px = l.px + t * l.dx;
+                line.py = l.py + t * l.dy;
+            }
+
+            float dx = lines[j].dx - l.dx;
+            float dy = lines[j].dy - l.dy;
+            float length = sqrtf(dx * dx + dy * dy);
+            line.dx = dx / length;
+            line.dy = dy / length;
+            projected.push_back(line);
+        }
+
+        float old_x = result_x, old_y = result_y;
+        if (solveInCircle(projected, radius, -l.dy, l.dx, true, result_x, result_y) < (int)projected.size())
+        {
+            // Can only fail from rounding; the old result is as good as it gets
+            result_x = old_x;
+            result_y = old_y;
+        }
+
+        distance = det(l.dx, l.dy, l.px - result_x, l.py - result_y);
+    }
+}
+
+void Crowd::solveShare(Scratch &scratch)
+{
+    int count = states.size();
+    for (;;)
+    {
+        int begin = next_state.fetch_add(CHUNK);
+        if (begin >= count)
+        {
+            return;
+        }
+
+        int end = std::min(begin + CHUNK, count);
+        for (int i = begin; i < end; i++)
+        {
+            solve(i, scratch);
+        }
+    }
+}
+
+void Crowd::work(int index)
+{
+    int seen = 0;
+    for (;;)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        wake.wait(lock, [&] { return stopping || round != seen; });
+        if (stopping)
+        {
+            return;
+        }
+        seen = round;
+        lock.unlock();
+
+        solveShare(scratch[index]);
+
+        lock.lock();
+        if (--busy == 0)
+        {
+            finished.notify_one();
+        }
+    }
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include "GameObject.h"
+#include "Vector3.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***************************************************************************//**
+Crowd steers groups of ::GameObject agents around each other before they touch,
+so agents following paths through the same spot slide past one another instead
+of piling up and leaving the ::Environment a heap of collisions to resolve.\n
+Every tick each agent is given the velocity it would like to move at, usually
+straight towards the next position on its path. Crowd::update then picks, for
+every agent, the velocity closest to that one that won't bring it into contact
+with any neighbor within the time horizon, assuming the neighbors do their half
+of the avoiding too (optimal reciprocal collision avoidance, ORCA). Only the x
+and y axes are considered.\n
+Neighbors are found through a grid rebuilt every update, so each agent only
+looks at the agents in the cells around it. Each agent's velocity only depends
+on the positions and velocities read at the start of the update, so with
+worker threads the agents are split between them and solved in parallel.
+\verbatim
+int agent = crowd.add(elf, elf->getDimsX() / 2, 5);
+...
+crowd.setPreferredVelocity(agent, (path.back() - elf->getPos()) * speed);
+crowd.update();
+steer(elf, crowd.getVelocity(agent));
+\endverbatim
+*******************************************************************************/
+class Crowd
+{
+    public:
+/***************************************************************************//**
+@fn Crowd(int num_threads)
+Creates an empty crowd. With num_threads greater than 0, that many worker
+threads help the calling thread solve agents in Crowd::update.
+@fn ~Crowd()
+Stops the worker threads. The agents' objects are not deleted.
+*******************************************************************************/
+        Crowd(int num_threads = 0);
+        ~Crowd();
+
+/***************************************************************************//**
+@fn int add(GameObject *object, float radius, float max_speed)
+Adds object as an agent taking up a circle of radius around its position and
+moving no faster than max_speed per game cycle, and returns its handle. The
+object must stay alive until it is removed.
+@fn void remove(int agent)
+Removes an agent. Its handle may be given to an agent added later.
+*******************************************************************************/
+        int add(GameObject *object, float radius, float max_speed);
+        void remove(int agent);
+
+/***************************************************************************//**
+@fn void setPreferredVelocity(int agent, Vector3 velocity)
+Sets the velocity agent would move at if nothing was in the way. Only x and y
+are used.
+@fn Vector3 getVelocity(int agent) const
+Returns the velocity the last Crowd::update chose for agent, with a z of 0.
+It is 0 until the first update.
+*******************************************************************************/
+        void setPreferredVelocity(int agent, Vector3 velocity);
+        Vector3 getVelocity(int agent) const { return Vector3(agents[agent].vx, agents[agent].vy, 0); }
+
+/***************************************************************************//**
+@fn void setTimeHorizon(float cycles)
+Sets how many game cycles ahead collisions are avoided. Longer horizons make
+agents turn away earlier but leave them less room to move. Defaults to 60.
+@fn void setNeighborDistance(float distance)
+Sets how far away other agents are taken into account. Should be at least the
+distance two agents can close within the time horizon. Defaults to 300.
+@fn void setMaxNeighbors(int count)
+Caps how many of the nearest neighbors each agent avoids. Defaults to 10.
+*******************************************************************************/
+        void setTimeHorizon(float cycles) { time_horizon = cycles; }
+        void setNeighborDistance(float distance) { neighbor_distance = distance; }
+        void setMaxNeighbors(int count) { max_neighbors = count; }
+
+/***************************************************************************//**
+@fn void update()
+Reads every agent's position and velocity from its object and chooses its new
+velocity. Call once per game cycle from the game thread, after setting the
+preferred velocities; the objects themselves are not changed.
+@fn int getNumAgents() const
+Returns the number of agents.
+*******************************************************************************/
+        void update();
+        int getNumAgents() const { return num_agents; }
+
+    private:
+        Crowd(const Crowd &);
+        Crowd &operator=(const Crowd &);
+
+        struct Agent {
+            GameObject *object; // NULL for a free handle
+            float radius, max_speed;
+            float pref_x, pref_y;
+            float vx, vy;       // Chosen by the last update
+        };
+
+        // Copy of an agent taken at the start of an update
+        struct State {
+            float x, y, vx, vy;
+            float radius, max_speed;
+            float pref_x, pref_y;
+        };
+
+        // Half-plane of allowed velocities: the left side of the line through
+        // point along direction
+        struct Line {
+            float px, py, dx, dy;
+        };
+
+        // Per-thread solve arrays
+        struct Scratch {
+            std::vector<std::pair<float, int> > neighbors; // Distance squared, state
+            std::vector<Line> lines;
+            std::vector<Line> projected;
+        };
+
+        static bool solveOnLine(const std::vector<Line> &lines, int line, float radius, float opt_x, float opt_y,
+                                bool direction, float &result_x, float &result_y);
+        static int solveInCircle(const std::vector<Line> &lines, float radius, float opt_x, float opt_y,
+                                 bool direction, float &result_x, float &result_y);
+        static void solveLeastPenetration(const std::vector<Line> &lines, int begin, float radius,
+                                          std::vector<Line> &projected, float &result_x, float &result_y);
+
+        int cellOf(const State &state) const;
+        void buildGrid();
+        void findNeighbors(int i, Scratch &scratch) const;
+        void solve(int i, Scratch &scratch);
+        void solveShare(Scratch &scratch);
+        void work(int index);
+
+        std::vector<Agent> agents;
+        std::vector<int> free_agents;
+        int num_agents;
+        float time_horizon, neighbor_distance;
+        int max_neighbors;
+
+        std::vector<State> states;
+        std::vector<int> state_agent; // Agent each state was copied from
+
+        // States bucketed by grid cell, cell i holding
+        // cell_states[cell_start[i]] up to cell_states[cell_start[i + 1]]
+        float min_x, min_y, cell_size;
+        int cells_x, cells_y;
+        std::vector<int> cell_start;
+        std::vector<int> cell_states;
+
+        std::vector<Scratch> scratch; // One per thread, the caller's first
+        std::vector<std::thread> workers;
+        std::mutex mtx;
+        std::condition_variable wake, finished;
+        std::atomic<int> next_state;
+        int round, busy;
+        bool stopping;
+};
@@ -21,6 +21,8 @@ Public methods
 Environment::Environment()
 {
     accel_gravity = 0;
+    update_budget = 0;
+    cycle = 0;
 }
 
 /*******************************************************************************
@@ -60,8 +62,9 @@ void Environment::remove(const GameObject *object)
 /*******************************************************************************
 update_objects
 ********************************************************************************
-DESCRIPTION : Sorts this, then calls update on all game objects in the list, or
-removes them if they're not alive.
+DESCRIPTION : Sorts this, then calls update on every game object that is due
+this cycle. An object is due once the cycles since its last update reach its
+tier's interval, and its time step covers every one of those cycles.
 If an object removes itself as part of its update, the next object in
 the list will get skipped. This is a minor bug, but has no currently known fix
 *******************************************************************************/
@@ -69,25 +72,104 @@ void Environment::updateObjects()
 {
     sort();
 
+    frame_vector<int> tiers;
+    assignTiers(tiers);
+
     int n = objects.size();
     for (int i = 0; i < n; i++)
     {
-        Vector3 g_force(0, 0, objects[i]->getMass() * getGravity());
-        objects[i]->applyForce(g_force);
-        objects[i]->update();
+        GameObject *object = objects[i];
+        // Objects added during this loop have no tier yet
+        int tier = i < (int)tiers.size() ? tiers[i] : 0;
+        int interval = tiers.empty() ? 1 : update_tiers[tier].interval;
+        int step = object->getLastUpdate() < 0 ? 1 : cycle - object->getLastUpdate();
+
+        if (step >= interval)
+        {
+            Vector3 g_force(0, 0, object->getMass() * getGravity() * step);
+            object->applyForce(g_force);
+            object->setTimeStep(step);
+            object->setInView(tier == 0);
+            object->setLastUpdate(cycle);
+            object->update();
+        }
         n = objects.size();
     }
+
+    cycle++;
+}
+
+/*******************************************************************************
+FUNCTION assignTiers
+********************************************************************************
+DESCRIPTION : Fills tiers with the index of each object's update tier. Leaves
+it empty when every object should be updated every cycle. If more objects fall
+in the first tier than the budget allows, the farthest are moved down a tier.
+*******************************************************************************/
+void Environment::assignTiers(frame_vector<int> &tiers) const
+{
+    if (update_tiers.empty() || focus_points.empty())
+    {
+        return;
+    }
+
+    tiers.resize(objects.size());
+    frame_vector<std::pair<float, int> > in_view;
+
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        // Distances are measured across the floor; height doesn't matter here
+        float nearest = -1;
+        for (size_t j = 0; j < focus_points.size(); j++)
+        {
+            float dx = objects[i]->getPosX() - focus_points[j].x;
+            float dy = objects[i]->getPosY() - focus_points[j].y;
+            float d = dx * dx + dy * dy;
+            if (nearest < 0 || d < nearest)
+            {
+                nearest = d;
+            }
+        }
+
+        int tier = update_tiers.size() - 1;
+        for (size_t t = 0; t < update_tiers.size(); t++)
+        {
+            if (nearest < update_tiers[t].radius * update_tiers[t].radius)
+            {
+                tier = t;
+                break;
+            }
+        }
+
+        tiers[i] = tier;
+        if (tier == 0)
+        {
+            in_view.push_back(std::pair<float, int>(nearest, i));
+        }
+    }
+
+    if (update_budget > 0 && update_tiers.size() > 1
+        && (int)in_view.size() > update_budget)
+    {
+        std::nth_element(in_view.begin(), in_view.begin() + update_budget, in_view.end());
+        for (size_t i = update_budget; i < in_view.size(); i++)
+        {
+            tiers[in_view[i].second] = 1;
+        }
+    }
 }
 
 /*******************************************************************************
 FUNCTION detectCollisions
 ********************************************************************************
 DESCRIPTION : Populates the collision_pairs list with pointers to colliding
-objects.
+objects. The list is cleared rather than replaced, so it keeps its capacity
+from one cycle to the next.
 *******************************************************************************/
 void Environment::detectCollisions()
 {
     collision_pairs.clear();
+    collision_pairs.reserve(objects.size());
 
     for (auto it1 = objects.begin(); it1 != objects.end(); ++it1){
         if ((*it1)->isCollidable()) {
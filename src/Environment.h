@@ -1,7 +1,27 @@
 #pragma once
 #include "GameObject.h"
+#include "FrameArena.h"
 #include <vector>
 
+/***************************************************************************//**
+An UpdateTier describes how often objects at a certain distance from the
+nearest focus point get updated.
+- radius Objects closer than this to a focus point may belong to this tier.
+- interval Objects in this tier are updated once every interval game cycles,
+  with a time step covering all of those cycles.
+*******************************************************************************/
+struct UpdateTier
+{
+    float radius;
+    int interval;
+
+    UpdateTier(float radius, int interval)
+    {
+        this->radius = radius;
+        this->interval = interval;
+    }
+};
+
 /***************************************************************************//**
 Environment contains a collection of ::GameObject pointers. It also defines a
 minimal set of rules the objects must play by; namely gravity. Any ::GameObject
@@ -10,7 +30,13 @@ to collide and render groups of objects.\n
 It should also be noted that each Environment takes ownership of its
 GameObjects. If you want to preserve a persistent ::GameObject (ie. the player),
 then you should take care to \link Environment::remove remove\endlink that
-object from the Environment before the Environment is destroyed.
+object from the Environment before the Environment is destroyed.\n
+By default every object is updated every game cycle. Large Environments can
+give a list of \link Environment::setUpdateTiers update tiers\endlink and
+\link Environment::setFocusPoints focus points\endlink (the camera, the
+players...) so objects far away from anything that matters are updated less
+often, and an \link Environment::setUpdateBudget update budget\endlink to cap
+how many objects are updated every cycle.
 *******************************************************************************/
 class Environment
 {
@@ -25,13 +51,14 @@ Destroys this and deletes all ::GameObject pointers within.
         ~Environment();
 
 /***************************************************************************//**
-@fn std::vector<GameObject *> getObjects() const
-Returns the Environments collection of object pointers as a vector.
+@fn const std::vector<GameObject *> &getObjects() const
+Returns the Environments collection of object pointers as a vector. The
+reference is only good until objects are added or removed.
 @fn float getGravity() const
 Returns this Environment's gravity. This is how much each object in the
 Environment will accelerate downward each game cycle.
 *******************************************************************************/
-        std::vector<GameObject *> getObjects() const { return objects; }
+        const std::vector<GameObject *> &getObjects() const { return objects; }
         float getGravity() const { return accel_gravity; }
 
 /***************************************************************************//**
@@ -51,15 +78,36 @@ not delete the object.
         void pushBack(GameObject *object) { objects.push_back(object); }
         void remove(const GameObject *object);
 
+/***************************************************************************//**
+@fn void setUpdateTiers(const std::vector<UpdateTier> &tiers)
+Sets the update tiers, ordered from nearest to farthest. The first tier should
+have an interval of 1; objects in it are considered in view. Objects beyond the
+last tier's radius belong to the last tier. Passing an empty vector updates
+every object every cycle.
+@fn void setFocusPoints(const std::vector<Vector3> &points)
+Sets the points distances are measured from, such as the camera and the
+players. Should be refreshed whenever they move. With no focus points every
+object is updated every cycle.
+@fn void setUpdateBudget(int budget)
+Caps the number of objects in the first tier. When more objects than this are
+close enough, the farthest ones are moved to the second tier. A budget of 0
+means no cap.
+*******************************************************************************/
+        void setUpdateTiers(const std::vector<UpdateTier> &tiers) { update_tiers = tiers; }
+        void setFocusPoints(const std::vector<Vector3> &points) { focus_points = points; }
+        void setUpdateBudget(int budget) { update_budget = budget; }
+
 /***************************************************************************//**
 @fn void updateObjects()
-Updates all GameObjects in the ::Environment. Should be called once per game
-cycle. Environment will also quicksort all objects by their y-values. This is so
-the objects will render from back to front.
+Updates all GameObjects in the ::Environment that are due this cycle according
+to their update tier. Should be called once per game cycle. Environment will
+also quicksort all objects by their y-values. This is so the objects will
+render from back to front.
 @fn void detectCollisions()
 Checks all objects against each other to determine which ones could be
 colliding. Populate a list of GameObject pointer pairs for potentially colliding
-objects.
+objects. The list is kept between cycles and cleared here, so it holds the
+pairs of the last call until the next one.
 @fn void resolveCollisions()
 Loops through all pairs in the collision pairs and collides them.
 @fn void clean()
@@ -83,8 +131,13 @@ back to front.
 *******************************************************************************/
         void sort();
         void destroyObjects();
+        void assignTiers(frame_vector<int> &tiers) const;
 
         std::vector<GameObject *> objects;
+        std::vector<UpdateTier> update_tiers;
+        std::vector<Vector3> focus_points;
+        int update_budget;
+        int cycle;
         std::vector<std::pair<GameObject *, GameObject *> > collision_pairs;
         float accel_gravity;
 };
\ No newline at end of file
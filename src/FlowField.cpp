@@ -0,0 +1,60 @@
+#include "FlowField.h"
+
+FlowField::FlowField()
+{
+    target = -1;
+    version = 0;
+    start_x = start_y = 0;
+    length = thickness = 0;
+    tiling = 1;
+    height = 0;
+}
+
+Vector3 FlowField::getDirection(Vector3 pos) const
+{
+    int index = getIndex(pos);
+    if (index < 0 || next[index] == index)
+    {
+        return Vector3();
+    }
+
+    Vector3 dir(next[index] % length - index % length, next[index] / length - index / length, 0);
+    dir.normalize();
+    return dir;
+}
+
+Vector3 FlowField::getNextPos(Vector3 pos) const
+{
+    int index = getIndex(pos);
+    if (index < 0 || next[index] == index)
+    {
+        return pos;
+    }
+
+    int n = next[index];
+    return Vector3(n % length * tiling + start_x, n / length * tiling + start_y, height);
+}
+
+int FlowField::getCost(Vector3 pos) const
+{
+    int index = getIndex(pos);
+    return index < 0 ? -1 : cost[index];
+}
+
+// Index of the node nearest pos, rounded the same way as Mesh, or -1 if pos is
+// off the mesh or the field is empty
+int FlowField::getIndex(Vector3 pos) const
+{
+    if (!isValid())
+    {
+        return -1;
+    }
+
+    int x = (pos.x - start_x + tiling / 2) / tiling;
+    int y = (pos.y - start_y + tiling / 2) / tiling;
+    if (x < 0 || x >= length || y < 0 || y >= thickness)
+    {
+        return -1;
+    }
+    return y * length + x;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "Vector3.h"
+#include <vector>
+
+/***************************************************************************//**
+A FlowField tells every node of a ::Mesh which way to step to reach one
+target. It is filled by Mesh::calcFlowField with a single Dijkstra search that
+starts at the target and spreads outwards, so any number of agents chasing the
+same target share one search instead of running one each.\n
+Steering is then a lookup: FlowField::getDirection takes an agent's position
+and returns the direction of the next node on its cheapest path, in constant
+time. Costs are the same as the A_STAR mode of Mesh::calcPath, so agents walk
+around objects, and only go through them when they are walled in.\n
+The field remembers the target node and the Mesh::getVersion it was built
+against. Calling Mesh::calcFlowField every tick is cheap; the search is only
+run again when the target moves to another node or objects were inserted or
+cleared.
+\verbatim
+mesh->calcFlowField(hero->getPos(), field);
+for (size_t i = 0; i < enemies.size(); i++)
+{
+    Vector3 dir = field.getDirection(enemies[i]->getPos());
+    enemies[i]->applyForce(dir * enemies[i]->getMass());
+}
+\endverbatim
+*******************************************************************************/
+class FlowField
+{
+    public:
+        FlowField();
+
+/***************************************************************************//**
+@fn Vector3 getDirection(Vector3 pos) const
+Returns a unit vector pointing from the node nearest pos towards the next node
+on the way to the target. Returns a zero vector at the target, off the mesh,
+or before the field has been calculated.
+@fn Vector3 getNextPos(Vector3 pos) const
+Returns the position of the next node on the way to the target, or pos itself
+where getDirection would return a zero vector.
+@fn int getCost(Vector3 pos) const
+Returns the cost of the path from the node nearest pos to the target, in the
+units of Mesh::STRAIGHT_COST, or -1 off the mesh.
+*******************************************************************************/
+        Vector3 getDirection(Vector3 pos) const;
+        Vector3 getNextPos(Vector3 pos) const;
+        int getCost(Vector3 pos) const;
+
+/***************************************************************************//**
+@fn bool isValid() const
+Returns true once the field has been calculated.
+@fn unsigned getVersion() const
+Returns the Mesh::getVersion the field was calculated against.
+*******************************************************************************/
+        bool isValid() const { return target >= 0; }
+        unsigned getVersion() const { return version; }
+
+    private:
+        friend class Mesh;
+
+        int getIndex(Vector3 pos) const;
+
+        int target;       // Node index of the target, or -1 before the first search
+        unsigned version; // Mesh version the field was built against
+
+        // Copied from the mesh so lookups don't need it
+        int start_x, start_y;
+        int length, thickness, tiling;
+        float height;
+
+        std::vector<int> cost; // Cost of the path from each node to target
+        std::vector<int> next; // Node to step to from each node; the target points at itself
+};
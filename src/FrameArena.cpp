@@ -0,0 +1,86 @@
+#include "FrameArena.h"
+#include <cstdint>
+
+FrameArena engine_arena;
+
+FrameArena::FrameArena(size_t capacity)
+{
+    this->capacity = capacity;
+    block = new char[capacity];
+    used = 0;
+    overflow_bytes = 0;
+    high_water = 0;
+}
+
+FrameArena::~FrameArena()
+{
+    reset();
+    delete[] block;
+}
+
+/*******************************************************************************
+FUNCTION allocate
+********************************************************************************
+DESCRIPTION : Bumps the offset into the main block. Requests that don't fit are
+given their own heap block, which lives until the next reset.
+*******************************************************************************/
+void *FrameArena::allocate(size_t bytes, size_t align)
+{
+    uintptr_t base = reinterpret_cast<uintptr_t>(block);
+    uintptr_t aligned = (base + used + align - 1) & ~(uintptr_t)(align - 1);
+    size_t offset = aligned - base;
+
+    if (offset + bytes <= capacity)
+    {
+        used = offset + bytes;
+        return block + offset;
+    }
+
+    // operator new aligns to max_align_t, which covers everything we hand out
+    char *extra = new char[bytes];
+    overflow.push_back(extra);
+    overflow_bytes += bytes;
+    return extra;
+}
+
+/*******************************************************************************
+FUNCTION reset
+********************************************************************************
+DESCRIPTION : Rewinds the main block. If this frame overflowed, the overflow
+blocks are freed and the main block is replaced by one that fits the frame.
+*******************************************************************************/
+void FrameArena::reset()
+{
+    size_t frame_bytes = used + overflow_bytes;
+    if (frame_bytes > high_water)
+    {
+        high_water = frame_bytes;
+    }
+
+    if (!overflow.empty())
+    {
+        for (size_t i = 0; i < overflow.size(); i++)
+        {
+            delete[] overflow[i];
+        }
+        overflow.clear();
+
+        // Leave headroom for alignment padding and slightly busier frames
+        delete[] block;
+        capacity = high_water + high_water / 2;
+        block = new char[capacity];
+    }
+
+    used = 0;
+    overflow_bytes = 0;
+}
+
+FrameArena &frame_arena()
+{
+    return engine_arena;
+}
+
+void reset_frame_arena()
+{
+    engine_arena.reset();
+}
@@ -0,0 +1,124 @@
+/***************************************************************************//**
+@defgroup frame_arena_group Frame Arena
+Many engine buffers only live for a single game cycle; the update tier of each
+object, the open and closed lists of a path search, the nodes overlapped by an
+object... Allocating them from the heap every tick is wasted work, so Bayou
+hands them out of a linear (bump) allocator instead. Memory is taken from the
+front of one large block, and the whole block is released at once when
+::update_game finishes the tick.\n
+Any container using ::FrameAllocator must not outlive the tick it was filled
+in, so never make one a member of anything that lasts longer than a function
+call. The arena isn't thread safe: only the game thread may allocate from it,
+and ::PathQueue workers never do. Allocations made outside ::update_game, such
+as the ones a State constructor makes inserting walls into a Mesh, are fine as
+long as they are gone before the call returns; they are released with the next
+cycle's. Include the file FrameArena.h to use the types documented here.
+@{
+*******************************************************************************/
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/***************************************************************************//**
+FrameArena is the linear allocator behind ::frame_arena. Allocating is a pointer
+bump, freeing individual allocations does nothing, and FrameArena::reset
+releases everything at once.\n
+If a frame asks for more memory than the block holds, the extra requests are
+served by temporary heap blocks. The next reset replaces the main block with
+one large enough for the whole frame, so a game that does the same amount of
+work each tick stops touching the heap after its first few frames.
+*******************************************************************************/
+class FrameArena
+{
+    public:
+/***************************************************************************//**
+@fn FrameArena(size_t capacity)
+Creates an arena whose main block holds \p capacity bytes.
+@fn ~FrameArena()
+Releases the main block and any overflow blocks.
+*******************************************************************************/
+        FrameArena(size_t capacity = 64 * 1024);
+        ~FrameArena();
+
+/***************************************************************************//**
+@fn void *allocate(size_t bytes, size_t align)
+Returns \p bytes of memory aligned to \p align, which must be a power of two.
+The memory stays valid until the next call to FrameArena::reset.
+@fn void reset()
+Releases every allocation made since the last reset. If the frame overflowed
+the main block, it is regrown to fit the frame's total usage.
+*******************************************************************************/
+        void *allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+        void reset();
+
+/***************************************************************************//**
+@fn size_t getCapacity() const
+Returns the size of the main block in bytes.
+@fn size_t getUsed() const
+Returns the number of bytes handed out since the last reset, including
+overflow.
+@fn size_t getHighWater() const
+Returns the largest number of bytes any single frame has used.
+*******************************************************************************/
+        size_t getCapacity() const { return capacity; }
+        size_t getUsed() const { return used + overflow_bytes; }
+        size_t getHighWater() const { return high_water; }
+
+    private:
+        FrameArena(const FrameArena &);
+        FrameArena &operator=(const FrameArena &);
+
+        char *block;
+        size_t capacity, used;
+        size_t overflow_bytes, high_water;
+        std::vector<char *> overflow;
+};
+
+/***************************************************************************//**
+@fn FrameArena &frame_arena()
+Returns the arena shared by the whole engine.
+@fn void reset_frame_arena()
+Releases everything allocated from ::frame_arena. ::update_game calls this at
+the end of every game cycle, so you should not need to call it yourself.
+*******************************************************************************/
+FrameArena &frame_arena();
+void reset_frame_arena();
+
+/***************************************************************************//**
+FrameAllocator is a standard library allocator that draws from ::frame_arena,
+so containers can be used as per-frame scratch space.
+\verbatim
+frame_vector<GameObject *> nearby;
+nearby.reserve(objects.size());
+\endverbatim
+*******************************************************************************/
+template <class T>
+class FrameAllocator
+{
+    public:
+        typedef T value_type;
+
+        FrameAllocator() {}
+        template <class U> FrameAllocator(const FrameAllocator<U> &) {}
+
+        T *allocate(size_t n)
+        {
+            return static_cast<T *>(frame_arena().allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *, size_t) {}
+};
+
+template <class T, class U>
+bool operator==(const FrameAllocator<T> &, const FrameAllocator<U> &) { return true; }
+
+template <class T, class U>
+bool operator!=(const FrameAllocator<T> &, const FrameAllocator<U> &) { return false; }
+
+/***************************************************************************//**
+@typedef frame_vector
+A std::vector whose storage comes from ::frame_arena.
+*******************************************************************************/
+template <class T>
+using frame_vector = std::vector<T, FrameAllocator<T> >;
+/**@}*/
@@ -1,4 +1,5 @@
 #include "GameObject.h"
+#include "Animation.h"
 
 GameObject::GameObject(
     Id id,
@@ -13,6 +14,10 @@ GameObject::GameObject(
     setScreenX(s_x);
     setScreenY(s_y);
     setAlive(true);
+    setTimeStep(1);
+    setInView(true);
+    setLastUpdate(-1);
+    animation_lag = 0;
 }
 
 GameObject::~GameObject()
@@ -22,14 +27,18 @@ GameObject::~GameObject()
 /*******************************************************************************
 FUNCTION update
 ********************************************************************************
-DESCRIPTION: Updates physics and animation.
+DESCRIPTION: Updates physics over the time step. The animation only catches up
+on the cycles it has missed once the object is in view.
 *******************************************************************************/
 void GameObject::update()
 {
-    body.update();
-    if (active_animation)
+    body.update(time_step);
+    animation_lag += time_step;
+
+    if (active_animation && in_view)
     {
-        active_animation->update();
+        active_animation->advance(animation_lag);
+        animation_lag = 0;
     }
 }
 
@@ -1,8 +1,9 @@
 #pragma once
 
-#include "Animation.h"
 #include "Body.h"
 
+class Animation;
+
 enum Id { BOUNDRY, OBJECT, };
 
 /***************************************************************************//**
@@ -21,6 +22,10 @@ out more about physical properties.
 - screen_y Same as screen_x, but to the up.
 - alive Boolean indicating if the object is still active. The containing
 ::Environment will delete the object if it isn't alive.
+- time_step Number of game cycles the next update covers. This is 1 unless the
+  containing ::Environment only updates the object every few cycles.
+- in_view Boolean indicating if the object is near enough to be seen. Objects
+  out of view don't advance their animation until they come back into view.
 *******************************************************************************/
 class GameObject
 {
@@ -64,6 +69,11 @@ class GameObject
         bool isStatic() const { return body.isStatic(); }
         bool isTangible() const { return body.isTangible(); }
 
+        /* Update level of detail getters */
+        int getTimeStep() const { return time_step; }
+        bool isInView() const { return in_view; }
+        int getLastUpdate() const { return last_update; }
+
         /* Setters */
         void setId(const Id i) { id = i; }
         void setActiveAnimation(Animation *animation) { active_animation = animation; }
@@ -94,10 +104,16 @@ class GameObject
 
         void applyForce(Vector3 force)    { body.applyForce(force); }
 
+        /* Update level of detail setters */
+        void setTimeStep(int t)            { time_step = t; }
+        void setInView(bool v)            { in_view = v; }
+        void setLastUpdate(int cycle)    { last_update = cycle; }
+
 /***************************************************************************//**
 @fn virtual void update() = 0
-Should be called once per game cycle. This update update's the object's
-currently playing animation and its ::Body.
+Should be called once per game cycle, or once every time step cycles. This
+update update's the object's ::Body over the time step, and its currently
+playing animation if the object is in view.
 @fn virtual void render(float scale = 1) const
 Draws the object's currently playing animation. The optional parameter \p scale
 will draw the animation at that scale in both x and y.
@@ -125,4 +141,10 @@ Perform game object logic as to what these objects should do when they collide.
         Animation *active_animation;
         float screen_x, screen_y;
         bool is_alive;
+
+        /* Update level of detail */
+        int time_step;
+        bool in_view;
+        int last_update;
+        int animation_lag;
 };
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "Manager.h"
+#include "Assets.h"
+#include "FrameArena.h"
 #include <cstdio>
 #include <memory>
 #include <stack>
@@ -70,10 +72,16 @@ void handle_key()
 }
 void update_game()
 {
+    // Assets loading in the background get a slice of every cycle
+    update_assets();
+
     if (!is_game_over())
         states.top()->update();
     else
         end_game();
+
+    // Everything drawn from the frame arena this cycle is released here
+    reset_frame_arena();
 }
 void render_game()
 {
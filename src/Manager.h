@@ -47,7 +47,8 @@ void pop_state();
 Calls State::handleKey on the active state.
 @fn void update_game()
 @ingroup manager_group
-Calls State::update on the active state.
+Finishes some background asset loads with ::update_assets, calls
+State::update on the active state, then resets ::frame_arena.
 @fn void render_game()
 @ingroup manager_group
 Calls State::render on the active state.
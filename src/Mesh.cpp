@@ -1,14 +1,70 @@
 #include "Mesh.h"
-#include <cstddef>
-#include <queue>
+#include "GameObject.h"
+#include "PathPolicy.h"
 #include <algorithm>
-#include <functional>
-#include <unordered_map>
-using std::unordered_map;
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 using std::vector;
 using std::pair;
-using std::priority_queue;
-using std::greater;
+
+// Offsets to the 8 neighbors of a node, orthogonal ones first
+const int Mesh::NEIGHBOR_DX[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+const int Mesh::NEIGHBOR_DY[8] = { -1, 0, 1, 0, -1, 1, 1, -1 };
+
+// Step costs are initialized in the class, but passing one by reference, as
+// std::max and std::pair do, needs a definition too
+const int Mesh::STRAIGHT_COST;
+const int Mesh::DIAGONAL_COST;
+const int Mesh::BLOCKED_COST;
+
+// Once the change log grows past this, its older half is dropped
+static const size_t MAX_CHANGE_LOG = 1 << 16;
+
+/*******************************************************************************
+Layout of a baked mesh file. The header is followed by the occupancy words, the
+object counts, then the component parents and ranks and the clearances if the
+flags say they were built, each starting on an 8 byte boundary. byte_order
+holds BAKE_BYTE_ORDER as the writing machine stored it, so a file baked on a
+machine of the other endianness is rejected rather than misread. key is the
+level key bake was given.
+*******************************************************************************/
+struct BakedMeshHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t flags;
+    int32_t start_x, start_y, length, thickness, tiling;
+    uint32_t key;
+    uint64_t file_size;
+};
+
+static const char BAKE_MAGIC[4] = { 'B', 'N', 'A', 'V' };
+static const uint32_t BAKE_VERSION = 2;
+static const uint32_t BAKE_BYTE_ORDER = 0x01020304;
+static const uint32_t BAKED_COMPONENTS = 1;
+static const uint32_t BAKED_CLEARANCE = 2;
+
+static size_t padTo8(size_t bytes)
+{
+    return (bytes + 7) & ~(size_t)7;
+}
+
+// Octile distance from (x, y) to the nearest node of the box (x0, y0)-(x1, y1)
+static int boxHeuristic(int x, int y, int x0, int y0, int x1, int y1)
+{
+    int dx = std::max(std::max(x0 - x, x - x1), 0);
+    int dy = std::max(std::max(y0 - y, y - y1), 0);
+    int diagonal = std::min(dx, dy);
+    return Mesh::DIAGONAL_COST * diagonal + Mesh::STRAIGHT_COST * (std::max(dx, dy) - diagonal);
+}
 
 Mesh::Mesh(int start_x, int start_y, int length, int thickness, int tiling) {
     this->start_x = start_x;
@@ -17,71 +73,466 @@ Mesh::Mesh(int start_x, int start_y, int length, int thickness, int tiling) {
     this->thickness = thickness;
     this->tiling = tiling;
     this->height = 32;
+    this->nodes_expanded = 0;
+    this->version = 0;
+    changed_at.assign(length * thickness, 0);
+    freed_at = 0;
+    log_floor = 0;
 
-    for (int i = 0; i < length; i++)
-    {
-        network.push_back(vector<MeshNode>());
-        for (int j = 0; j < thickness; j++)
-        {
-            MeshNode node;
-            node.coords = pair<int, int>(i, j);
-            node.pos = getPosFromIndices(node.coords);
-            network[i].push_back(node);
-        }
-    }
+    occupancy.assign((length * thickness + 63) / 64, 0);
+    refcounts.assign(length * thickness, 0);
+}
+
+// An empty mesh, for copySearchData to fill
+Mesh::Mesh()
+{
+    start_x = start_y = 0;
+    length = thickness = 0;
+    tiling = 1;
+    height = 32;
+    nodes_expanded = 0;
+    version = 0;
+    freed_at = 0;
+    log_floor = 0;
 }
 
 Mesh::~Mesh()
 {
 }
 
+/*******************************************************************************
+Copies from mesh only what a search of it reads: its position and size, the
+occupancy bits, the component labels, brought up to date, and the clearance
+map. Objects, per node counts, the change log, the hierarchy and the path cache
+are left out, so this mesh can be searched but not changed. The vectors keep
+their capacity, so copying into the same mesh again doesn't allocate unless
+mesh grew.
+*******************************************************************************/
+void Mesh::copySearchData(const Mesh &mesh)
+{
+    start_x = mesh.start_x;
+    start_y = mesh.start_y;
+    length = mesh.length;
+    thickness = mesh.thickness;
+    tiling = mesh.tiling;
+    height = mesh.height;
+    version = mesh.version;
+
+    occupancy = mesh.occupancy;
+    components = mesh.components;
+    components.refresh(*this);
+    clearance_map.clearance = mesh.clearance_map.clearance;
+}
+
 /*******************************************************************************
 Inserts a new GameObject pointer onto the mesh. Each node this object overlaps
-will gain a constant pointer to this object.
+has its count of objects raised. Inserting an object that is already on the
+mesh updates it instead.
 *******************************************************************************/
 void Mesh::insertObject(const GameObject *new_object)
 {
-    objects.push_back(new_object);
-    auto coordinates = getNodesInObject(new_object);
+    if (footprints.count(new_object))
+    {
+        updateObject(new_object);
+        return;
+    }
+
+    Footprint area = getFootprint(new_object);
+    footprints[new_object] = area;
+
+    frame_vector<int> changed;
+    for (int j = area.y0; j < area.y1; j++)
+    {
+        for (int i = area.x0; i < area.x1; i++)
+        {
+            addToNode(toIndex(i, j), changed);
+        }
+    }
+    markDirty(changed);
+}
+
+/*******************************************************************************
+Works out which nodes the object covers now, and only touches the ones it
+moved onto or off of since it was inserted or last updated.
+*******************************************************************************/
+void Mesh::updateObject(const GameObject *object)
+{
+    auto found = footprints.find(object);
+    if (found == footprints.end())
+    {
+        insertObject(object);
+        return;
+    }
+
+    Footprint old_area = found->second;
+    Footprint new_area = getFootprint(object);
+    if (old_area == new_area)
+    {
+        return;
+    }
+    found->second = new_area;
+
+    frame_vector<int> changed;
+    for (int j = old_area.y0; j < old_area.y1; j++)
+    {
+        for (int i = old_area.x0; i < old_area.x1; i++)
+        {
+            if (!new_area.contains(i, j))
+            {
+                removeFromNode(toIndex(i, j), changed);
+            }
+        }
+    }
+    for (int j = new_area.y0; j < new_area.y1; j++)
+    {
+        for (int i = new_area.x0; i < new_area.x1; i++)
+        {
+            if (!old_area.contains(i, j))
+            {
+                addToNode(toIndex(i, j), changed);
+            }
+        }
+    }
+    markDirty(changed);
+}
+
+void Mesh::removeObject(const GameObject *object)
+{
+    auto found = footprints.find(object);
+    if (found == footprints.end())
+    {
+        return;
+    }
+
+    Footprint area = found->second;
+    footprints.erase(found);
 
-    for (size_t i = 0; i < coordinates.size(); i++)
+    frame_vector<int> changed;
+    for (int j = area.y0; j < area.y1; j++)
     {
-        auto xy = coordinates[i];
-        if (inBounds(xy.first, xy.second))
+        for (int i = area.x0; i < area.x1; i++)
         {
-            network[xy.first][xy.second].objects.push_back(new_object);
+            removeFromNode(toIndex(i, j), changed);
         }
     }
+    markDirty(changed);
+}
+
+void Mesh::blockNode(int index)
+{
+    frame_vector<int> changed;
+    addToNode(index, changed);
+    markDirty(changed);
+}
+
+void Mesh::unblockNode(int index)
+{
+    if (refcounts[index] == 0)
+    {
+        return;
+    }
+
+    frame_vector<int> changed;
+    removeFromNode(index, changed);
+    markDirty(changed);
 }
 
 /*******************************************************************************
-Finds all nodes contained within each GameObject in the objects vector and
-clears their lists before clearing the objects vector
+Empties every node that held an object, and forgets all objects
 *******************************************************************************/
 void Mesh::clearObjects()
 {
-    for (size_t i = 0; i < objects.size(); i++)
+    frame_vector<int> changed;
+    for (size_t i = 0; i < occupancy.size(); i++)
+    {
+        for (uint64_t word = occupancy[i]; word; word &= word - 1)
+        {
+            changed.push_back(i * 64 + __builtin_ctzll(word));
+        }
+    }
+
+    std::fill(occupancy.begin(), occupancy.end(), 0);
+    std::fill(refcounts.begin(), refcounts.end(), 0);
+    footprints.clear();
+    markDirty(changed);
+}
+
+// Counts one more object on the node, and sets its bit if it was empty
+void Mesh::addToNode(int index, frame_vector<int> &changed)
+{
+    if (refcounts[index]++ == 0)
+    {
+        occupancy[index >> 6] |= (uint64_t)1 << (index & 63);
+        changed.push_back(index);
+    }
+}
+
+// Counts one less object on the node, and clears its bit once it is empty
+void Mesh::removeFromNode(int index, frame_vector<int> &changed)
+{
+    if (--refcounts[index] == 0)
+    {
+        occupancy[index >> 6] &= ~((uint64_t)1 << (index & 63));
+        changed.push_back(index);
+    }
+}
+
+/*******************************************************************************
+Builds the abstract graph HIERARCHICAL searches plan on.
+*******************************************************************************/
+void Mesh::buildHierarchy(int cluster_size)
+{
+    hierarchy.build(*this, cluster_size);
+}
+
+void Mesh::buildComponents()
+{
+    components.build(*this);
+}
+
+void Mesh::buildClearance()
+{
+    clearance_map.build(*this);
+}
+
+/*******************************************************************************
+A node is tiling wide, so an agent of radius standing on one overlaps the nodes
+up to radius / tiling + 1/2 steps away, and all of those must be free.
+*******************************************************************************/
+int Mesh::getRequiredClearance(float radius) const
+{
+    int clearance = (int)ceil(radius / tiling + 0.5f);
+    return std::max(1, std::min(clearance, (int)ClearanceMap::MAX_CLEARANCE));
+}
+
+bool Mesh::bake(const char *path, uint32_t key)
+{
+    components.refresh(*this);
+
+    BakedMeshHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BAKE_MAGIC, sizeof(header.magic));
+    header.version = BAKE_VERSION;
+    header.byte_order = BAKE_BYTE_ORDER;
+    header.flags = (components.isBuilt() ? BAKED_COMPONENTS : 0) | (clearance_map.isBuilt() ? BAKED_CLEARANCE : 0);
+    header.start_x = start_x;
+    header.start_y = start_y;
+    header.length = length;
+    header.thickness = thickness;
+    header.tiling = tiling;
+    header.key = key;
+
+    // Every section, in file order
+    int num_nodes = length * thickness;
+    const void *data[5] = { &occupancy[0], &refcounts[0], NULL, NULL, NULL };
+    size_t bytes[5] = { occupancy.size() * sizeof(uint64_t), num_nodes * sizeof(int), 0, 0, 0 };
+    if (header.flags & BAKED_COMPONENTS)
+    {
+        data[2] = &components.parent[0];
+        bytes[2] = num_nodes * sizeof(int);
+        data[3] = &components.rank[0];
+        bytes[3] = num_nodes;
+    }
+    if (header.flags & BAKED_CLEARANCE)
+    {
+        data[4] = &clearance_map.clearance[0];
+        bytes[4] = num_nodes;
+    }
+
+    header.file_size = sizeof(header);
+    for (int i = 0; i < 5; i++)
+    {
+        header.file_size += padTo8(bytes[i]);
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    static const char zeros[8] = { 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int i = 0; ok && i < 5; i++)
+    {
+        if (bytes[i] > 0)
+        {
+            ok = fwrite(data[i], bytes[i], 1, file) == 1
+                 && fwrite(zeros, padTo8(bytes[i]) - bytes[i], 1, file) <= 1;
+        }
+    }
+    return fclose(file) == 0 && ok;
+}
+
+Mesh *Mesh::load(const char *path, uint32_t key)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    struct stat info;
+    void *mapping = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(BakedMeshHeader))
+    {
+        mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    const char *file = (const char *)mapping;
+    BakedMeshHeader header;
+    memcpy(&header, file, sizeof(header));
+
+    // The size of the mesh is checked before it is multiplied out, so a damaged
+    // header can't overflow the node count
+    bool ok = memcmp(header.magic, BAKE_MAGIC, sizeof(header.magic)) == 0 && header.version == BAKE_VERSION
+              && header.byte_order == BAKE_BYTE_ORDER && header.key == key && header.length > 0
+              && header.thickness > 0 && header.length <= INT_MAX / header.thickness && header.tiling > 0;
+    int num_nodes = ok ? header.length * header.thickness : 0;
+    size_t words = (num_nodes + 63) / 64;
+    size_t expected = sizeof(header) + padTo8(words * sizeof(uint64_t)) + padTo8(num_nodes * sizeof(int));
+    if (header.flags & BAKED_COMPONENTS)
+    {
+        expected += padTo8(num_nodes * sizeof(int)) + padTo8(num_nodes);
+    }
+    if (header.flags & BAKED_CLEARANCE)
+    {
+        expected += padTo8(num_nodes);
+    }
+
+    if (!ok || header.file_size != expected || (off_t)expected != info.st_size)
+    {
+        munmap(mapping, info.st_size);
+        return NULL;
+    }
+
+    Mesh *mesh = new Mesh(header.start_x, header.start_y, header.length, header.thickness, header.tiling);
+    const char *section = file + sizeof(header);
+
+    const uint64_t *bits = (const uint64_t *)section;
+    mesh->occupancy.assign(bits, bits + words);
+    section += padTo8(words * sizeof(uint64_t));
+
+    const int *counts = (const int *)section;
+    mesh->refcounts.assign(counts, counts + num_nodes);
+    section += padTo8(num_nodes * sizeof(int));
+
+    if (header.flags & BAKED_COMPONENTS)
+    {
+        MeshComponents &components = mesh->components;
+        const int *parents = (const int *)section;
+        components.parent.assign(parents, parents + num_nodes);
+        section += padTo8(num_nodes * sizeof(int));
+
+        const unsigned char *ranks = (const unsigned char *)section;
+        components.rank.assign(ranks, ranks + num_nodes);
+        section += padTo8(num_nodes);
+
+        components.is_pending.assign(num_nodes, 0);
+        components.visited.assign(num_nodes, 0);
+        components.generation = 1;
+    }
+
+    if (header.flags & BAKED_CLEARANCE)
+    {
+        const unsigned char *clearance = (const unsigned char *)section;
+        mesh->clearance_map.clearance.assign(clearance, clearance + num_nodes);
+    }
+
+    munmap(mapping, info.st_size);
+    return mesh;
+}
+
+bool Mesh::isReachable(Vector3 start, Vector3 target)
+{
+    int start_index = getNodeIndex(start);
+    int target_index = getNodeIndex(target);
+    if (start_index < 0 || target_index < 0)
+    {
+        return false;
+    }
+
+    if (!components.isBuilt())
+    {
+        components.build(*this);
+    }
+    components.refresh(*this);
+    int label = components.getComponent(*this, start_index);
+    return label >= 0 && label == components.getComponent(*this, target_index);
+}
+
+// Moves to a new version and tells the search accelerators which nodes just
+// became blocked or free. Nothing happens if no node did.
+void Mesh::markDirty(const frame_vector<int> &nodes)
+{
+    if (nodes.empty())
+    {
+        return;
+    }
+
+    version++;
+    for (size_t i = 0; i < nodes.size(); i++)
     {
-        auto nodes = getNodesInObject(objects[i]);
-        for (size_t j = 0; j < nodes.size(); j++)
+        changed_at[nodes[i]] = version;
+        if (!isBlocked(nodes[i]))
         {
-            auto xy = nodes[j];
-            network[xy.first][xy.second].objects.clear();
+            freed_at = version;
         }
+        change_log.push_back(pair<unsigned, int>(version, nodes[i]));
+        hierarchy.markDirty(nodes[i] % length, nodes[i] / length);
+    }
+    components.markChanged(*this, nodes);
+    clearance_map.markChanged(*this, nodes);
+
+    if (change_log.size() > MAX_CHANGE_LOG)
+    {
+        size_t half = change_log.size() / 2;
+        log_floor = change_log[half - 1].first;
+        change_log.erase(change_log.begin(), change_log.begin() + half);
+    }
+}
+
+/*******************************************************************************
+Appends to nodes every node that changed after version since. Returns false if
+some of those changes were already dropped from the log.
+*******************************************************************************/
+bool Mesh::getChangesSince(unsigned since, frame_vector<int> &nodes) const
+{
+    if (since < log_floor)
+    {
+        return false;
+    }
+
+    auto first = std::upper_bound(change_log.begin(), change_log.end(),
+                                  pair<unsigned, int>(since, INT_MAX));
+    for (auto it = first; it != change_log.end(); ++it)
+    {
+        nodes.push_back(it->second);
     }
-    objects.clear();
+    return true;
 }
 
 /*******************************************************************************
 Uses A* to return a vector of Vector3's representing the path between start
-and target. This will avoid all game objects by setting nodes f scores to
-incredibly high values if they have objects on them. Needs to be updated to
-allow passing of a custom function object to allow custom priorities for nodes.
-You wouldn't want your ai to avoid healing potions, right?
+and target. This will avoid all game objects by adding a huge cost to entering
+nodes which have objects on them. To weigh nodes differently, so your ai
+doesn't avoid healing potions, use the overload taking a ::PathPolicy.
 *******************************************************************************/
-vector<Vector3> Mesh::calcPath(Vector3 start, Vector3 target)
+vector<Vector3> Mesh::calcPath(Vector3 start, Vector3 target, PathOptions options)
 {
     vector<Vector3> path;
+    calcPath(start, target, path, options);
+    return path;
+}
+
+void Mesh::calcPath(Vector3 start, Vector3 target, vector<Vector3> &path, PathOptions options)
+{
+    path.clear();
     pair<int, int> start_coords = getIndicesFromPos(start);
     pair<int, int> target_coords = getIndicesFromPos(target);
 
@@ -89,127 +540,852 @@ vector<Vector3> Mesh::calcPath(Vector3 start, Vector3 target)
     if (!inBounds(start_coords.first, start_coords.second)
         || !inBounds(target_coords.first, target_coords.second))
     {
-        return path;
+        return;
+    }
+
+    int start_index = toIndex(start_coords.first, start_coords.second);
+    int target_index = toIndex(target_coords.first, target_coords.second);
+
+    if (options.unreachable != CROSS_OBJECTS && !components.isBuilt())
+    {
+        components.build(*this);
+    }
+    components.refresh(*this);
+
+    // Paths for wide agents are not cached: an object moving in next to one
+    // narrows it without touching any node on it
+    int clearance = getRequiredClearance(options.radius);
+    if (clearance > 1 && !clearance_map.isBuilt())
+    {
+        clearance_map.build(*this);
+    }
+
+    const vector<Vector3> *cached = NULL;
+    if (clearance == 1)
+    {
+        cached = path_cache.find(*this, start_index, target_index, options.getProfile());
+    }
+    if (cached)
+    {
+        path = *cached;
+        nodes_expanded = 0;
+        return;
+    }
+
+    int goal = resolveGoal(start_index, target_index, options);
+    if (goal < 0)
+    {
+        nodes_expanded = 0;
+        return;
+    }
+
+    bool found = false;
+    if (options.mode == HIERARCHICAL && hierarchy.isBuilt() && clearance == 1)
+    {
+        frame_vector<int> nodes;
+        found = hierarchy.findPath(*this, start_index, goal, nodes);
+        nodes_expanded = hierarchy.getNodesExpanded();
+        for (size_t i = 0; found && i < nodes.size(); i++)
+        {
+            path.push_back(getPos(nodes[i]));
+        }
+    }
+
+    if (!found)
+    {
+        found = findPath(search_space, start_index, goal, options, path);
+        nodes_expanded = search_space.expanded;
+    }
+
+    if (found && options.any_angle)
+    {
+        smoothPath(start_index, path, clearance);
+    }
+    // A path to a substitute goal is not cached: the real one may become
+    // reachable without any node on the path changing
+    if (found && goal == target_index && clearance == 1)
+    {
+        path_cache.insert(*this, start_index, target_index, options.getProfile(), path);
+    }
+}
+
+void Mesh::calcPath(Vector3 start, Vector3 target, vector<Vector3> &path, PathPlanner &planner)
+{
+    path.clear();
+    pair<int, int> start_coords = getIndicesFromPos(start);
+    pair<int, int> target_coords = getIndicesFromPos(target);
+
+    if (!inBounds(start_coords.first, start_coords.second)
+        || !inBounds(target_coords.first, target_coords.second))
+    {
+        return;
+    }
+
+    frame_vector<int> nodes;
+    int start_index = toIndex(start_coords.first, start_coords.second);
+    int target_index = toIndex(target_coords.first, target_coords.second);
+    bool found = planner.findPath(*this, start_index, target_index, nodes);
+    nodes_expanded = planner.getNodesExpanded();
+
+    for (size_t i = 0; found && i < nodes.size(); i++)
+    {
+        path.push_back(getPos(nodes[i]));
+    }
+}
+
+/*******************************************************************************
+Runs Dijkstra's algorithm backwards from target over the whole mesh. Each node
+ends up pointing at the neighbor it should step to, which is the one it was
+reached from. Moving from a node into a neighbor costs the same as it does in
+search, so the direction of travel matters: the search relaxes the move from
+each neighbor into the node being expanded.
+*******************************************************************************/
+bool Mesh::calcFlowField(Vector3 target, FlowField &field)
+{
+    pair<int, int> target_coords = getIndicesFromPos(target);
+    if (!inBounds(target_coords.first, target_coords.second))
+    {
+        return false;
+    }
+
+    int goal = toIndex(target_coords.first, target_coords.second);
+    int num_nodes = length * thickness;
+    if (field.target == goal && field.version == version && (int)field.cost.size() == num_nodes)
+    {
+        return false;
+    }
+
+    field.target = goal;
+    field.version = version;
+    field.start_x = start_x;
+    field.start_y = start_y;
+    field.length = length;
+    field.thickness = thickness;
+    field.tiling = tiling;
+    field.height = height;
+    field.cost.assign(num_nodes, INT_MAX);
+    field.next.assign(num_nodes, -1);
+
+    flow_open.resize(num_nodes);
+    nodes_expanded = 0;
+
+    field.cost[goal] = 0;
+    field.next[goal] = goal;
+    flow_open.push(goal, 0);
+
+    while (!flow_open.empty())
+    {
+        int q = flow_open.pop();
+        int q_cost = field.cost[q];
+        nodes_expanded++;
+
+        int qx = q % length;
+        int qy = q / length;
+        bool q_blocked = isBlocked(q);
+
+        for (int i = 0; i < 8; i++)
+        {
+            int nx = qx + NEIGHBOR_DX[i];
+            int ny = qy + NEIGHBOR_DY[i];
+            if (!inBounds(nx, ny))
+            {
+                continue;
+            }
+
+            // Cost of stepping from n into q, corner included
+            int step = i < 4 ? STRAIGHT_COST : DIAGONAL_COST;
+            if (q_blocked
+                || (i >= 4 && (isBlocked(toIndex(nx, qy)) || isBlocked(toIndex(qx, ny)))))
+            {
+                step += BLOCKED_COST;
+            }
+
+            if (q_cost > INT_MAX / 2 - step)
+            {
+                continue;
+            }
+
+            int n = toIndex(nx, ny);
+            int cost = q_cost + step;
+            if (cost < field.cost[n])
+            {
+                field.cost[n] = cost;
+                field.next[n] = q;
+                flow_open.push(n, cost);
+            }
+        }
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+Runs the flat (A* or Jump Point) search selected by options in space and
+appends the resulting path. Only reads the mesh, so any number of threads can
+call it at once on the same mesh, each with its own space. Wide agents always
+get A*, with nodes too near objects costed like objects.
+*******************************************************************************/
+bool Mesh::findPath(SearchSpace &space, int start, int goal, PathOptions options, vector<Vector3> &path) const
+{
+    bool found = false;
+    int clearance = getRequiredClearance(options.radius);
+    if (clearance > 1 && clearance_map.isBuilt())
+    {
+        if (search(space, start, goal, KeepClearance(clearance)))
+        {
+            buildPath(space, start, goal, path);
+            return true;
+        }
+        return false;
+    }
+
+    if (options.mode == JUMP_POINT)
+    {
+        found = searchJumpPoints(space, start, goal);
+    }
+    if (!found)
+    {
+        found = search(space, start, goal, AvoidObjects());
+    }
+
+    if (found)
+    {
+        buildPath(space, start, goal, path);
+    }
+    return found;
+}
+
+void Mesh::calcPaths(const vector<Vector3> &starts, Vector3 target, PathBatch &batch, PathOptions options)
+{
+    calcPaths(starts, vector<Vector3>(1, target), batch, options);
+}
+
+/*******************************************************************************
+Sorts the starts into those the shared search serves and those that need a
+search of their own, runs the detours first since they reuse the same search
+arrays, then the shared search, and finally walks each start's parents to the
+nearest goal to fill the batch in order. Starts not served at all are marked -1,
+detours -2.
+*******************************************************************************/
+void Mesh::calcPaths(const vector<Vector3> &starts, const vector<Vector3> &targets, PathBatch &batch,
+                     PathOptions options)
+{
+    batch.points.clear();
+    batch.offsets.assign(1, 0);
+    nodes_expanded = 0;
+
+    frame_vector<int> goals;
+    for (size_t i = 0; i < targets.size(); i++)
+    {
+        int goal = getNodeIndex(targets[i]);
+        if (goal >= 0)
+        {
+            goals.push_back(goal);
+        }
+    }
+
+    if (options.unreachable != CROSS_OBJECTS && !components.isBuilt())
+    {
+        components.build(*this);
+    }
+    components.refresh(*this);
+
+    int clearance = getRequiredClearance(options.radius);
+    if (clearance > 1 && !clearance_map.isBuilt())
+    {
+        clearance_map.build(*this);
+    }
+
+    frame_vector<int> nodes(starts.size(), -1);
+    frame_vector<int> shared;
+    vector<Vector3> path;
+    frame_vector<Vector3> detours;
+    frame_vector<int> detour_offsets(1, 0);
+    for (size_t i = 0; i < starts.size(); i++)
+    {
+        int start = getNodeIndex(starts[i]);
+        if (start < 0 || goals.empty())
+        {
+            continue;
+        }
+
+        int nearest = goals[0];
+        bool reachable = !components.isBuilt() || components.getComponent(*this, start) < 0;
+        for (size_t j = 0; j < goals.size() && !reachable; j++)
+        {
+            reachable = components.getComponent(*this, goals[j]) == components.getComponent(*this, start);
+            if (heuristic(start, goals[j]) < heuristic(start, nearest))
+            {
+                nearest = goals[j];
+            }
+        }
+
+        if (reachable || options.unreachable == CROSS_OBJECTS)
+        {
+            nodes[i] = start;
+            shared.push_back(start);
+        }
+        else if (options.unreachable == NEAREST_REACHABLE)
+        {
+            PathOptions detour = options;
+            detour.mode = A_STAR;
+            path.clear();
+            int goal = resolveGoal(start, nearest, detour);
+            if (findPath(search_space, start, goal, detour, path) && options.any_angle)
+            {
+                smoothPath(start, path, clearance);
+            }
+            nodes_expanded += search_space.expanded;
+            detours.insert(detours.end(), path.begin(), path.end());
+            detour_offsets.push_back(detours.size());
+            nodes[i] = -2;
+        }
+    }
+
+    if (!shared.empty())
+    {
+        searchBackward(search_space, goals, shared, clearance);
+        nodes_expanded += search_space.expanded;
+    }
+
+    int detour = 0;
+    for (size_t i = 0; i < starts.size(); i++)
+    {
+        if (nodes[i] == -2)
+        {
+            batch.points.insert(batch.points.end(), detours.begin() + detour_offsets[detour],
+                                detours.begin() + detour_offsets[detour + 1]);
+            detour++;
+        }
+        else if (nodes[i] >= 0 && search_space.nodes[nodes[i]].closed == search_space.generation)
+        {
+            // Parents point towards the goal, so the path comes out start first
+            path.clear();
+            for (int cur = nodes[i]; search_space.nodes[cur].parent != cur; )
+            {
+                cur = search_space.nodes[cur].parent;
+                path.push_back(getPos(cur));
+            }
+            std::reverse(path.begin(), path.end());
+            if (options.any_angle)
+            {
+                smoothPath(nodes[i], path, clearance);
+            }
+            batch.points.insert(batch.points.end(), path.begin(), path.end());
+        }
+        batch.offsets.push_back(batch.points.size());
+    }
+}
+
+/*******************************************************************************
+Decides which node to search for, using the component labels, which must have
+been refreshed. Returns goal itself when it can be reached over free nodes, or
+when that can't be told: no labels, or start is covered by an object. Otherwise
+returns -1 for GIVE_UP, and for CROSS_OBJECTS still returns goal but switches
+options to A_STAR, since the other modes would only fail and fall back to it.
+For NEAREST_REACHABLE, looks at the nodes around goal in growing squares for
+the one in start's component nearest goal. A node r squares out is at least
+r * STRAIGHT_COST away, so the search stops once that passes the best found.
+*******************************************************************************/
+int Mesh::resolveGoal(int start, int goal, PathOptions &options) const
+{
+    if (!components.isBuilt())
+    {
+        return goal;
+    }
+    int label = components.getComponent(*this, start);
+    if (label < 0 || components.getComponent(*this, goal) == label)
+    {
+        return goal;
     }
 
-    // Initialize the open list. These are nodes which may be examined.
-    vector<MeshNode> open_list;
+    if (options.unreachable == GIVE_UP)
+    {
+        return -1;
+    }
+    if (options.unreachable == CROSS_OBJECTS)
+    {
+        options.mode = A_STAR;
+        return goal;
+    }
 
-    // The path will be reconstructed from this once we find the goal
-    // Any node addresses in this map are nodes we've examined.
-    unordered_map <const MeshNode *, bool> closed_list;
-    
-    // Put starting node on open list
-    MeshNode start_node = network[start_coords.first][start_coords.second];
-    start_node.f = 0;
-    start_node.g = 0;
-    start_node.h = 0;
-    open_list.push_back(network[start_coords.first][start_coords.second]);
-    
-    // While the open list is not empty
-    while (!open_list.empty())
+    int gx = goal % length;
+    int gy = goal / length;
+    int best = -1;
+    int best_cost = INT_MAX;
+    for (int r = 1; r < std::max(length, thickness) && r * STRAIGHT_COST < best_cost; r++)
     {
-        // Find the node with the least f on the open list, call it "q"
-        MeshNode q = open_list.back();
+        for (int y = std::max(gy - r, 0); y <= std::min(gy + r, thickness - 1); y++)
+        {
+            // Only the edge of the square: every column on its top and bottom
+            // rows, the two end columns on the rows between
+            int step = (y == gy - r || y == gy + r) ? 1 : 2 * r;
+            for (int x = gx - r; x <= gx + r; x += step)
+            {
+                if (x < 0 || x >= length)
+                {
+                    continue;
+                }
+
+                int n = toIndex(x, y);
+                if (components.getComponent(*this, n) == label && heuristic(n, goal) < best_cost)
+                {
+                    best = n;
+                    best_cost = heuristic(n, goal);
+                }
+            }
+        }
+    }
+    return best;
+}
+
+/*******************************************************************************
+A* run backwards, from every goal at once towards the starts. Each node's g is
+the cost of its cheapest path to a goal, and its parent is the next node on
+that path; goals are their own parents. Moving from a neighbor into the node
+being expanded costs what it does in search. The heuristic is the octile
+distance to the box around all starts, which is never more than the distance to
+the nearest one, so every start is popped with its cheapest path. The search
+stops once all starts have been popped. starts is sorted in place. With a
+clearance above 1, nodes with less, and their corners, are costed like objects,
+as KeepClearance does.
+*******************************************************************************/
+void Mesh::searchBackward(SearchSpace &space, const frame_vector<int> &goals, frame_vector<int> &starts,
+                          int clearance) const
+{
+    space.begin(length * thickness);
+    unsigned gen = space.generation;
+
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+    int remaining = starts.size();
 
-        // Pop q off the open list
-        open_list.pop_back();
+    int x0 = length, y0 = thickness, x1 = -1, y1 = -1;
+    for (size_t i = 0; i < starts.size(); i++)
+    {
+        x0 = std::min(x0, starts[i] % length);
+        x1 = std::max(x1, starts[i] % length);
+        y0 = std::min(y0, starts[i] / length);
+        y1 = std::max(y1, starts[i] / length);
+    }
 
-        // Mark q on the closed list and save q to the network
-        network[q.coords.first][q.coords.second] = q;
-        closed_list[&network[q.coords.first][q.coords.second]] = true;
+    for (size_t i = 0; i < goals.size(); i++)
+    {
+        SearchNode &goal = space.nodes[goals[i]];
+        if (goal.seen == gen)
+        {
+            continue;
+        }
+        goal.g = 0;
+        goal.parent = goals[i];
+        goal.seen = gen;
+        int h = boxHeuristic(goals[i] % length, goals[i] / length, x0, y0, x1, y1);
+        space.open.push(goals[i], pair<int, int>(h, h));
+    }
 
-        // Generate q's neighbors and set their parents to q
-        vector<pair<int, int> > neighbor_coords = getNeighbors(q.coords);
+    while (!space.open.empty())
+    {
+        int q = space.open.pop();
+        SearchNode &current = space.nodes[q];
+        current.closed = gen;
+        space.expanded++;
 
-        // Test each neighbor
-        for (size_t i = 0; i < neighbor_coords.size(); i++)
+        if (std::binary_search(starts.begin(), starts.end(), q) && --remaining == 0)
         {
-            MeshNode successor;
-            successor.coords = neighbor_coords[i];
-            successor.parent = q.coords;
-            successor.pos = network[successor.coords.first][successor.coords.second].pos;
-            successor.objects = network[successor.coords.first][successor.coords.second].objects;
+            return;
+        }
 
-            // successor.g = q.g + distance between successor and q
-            successor.g = q.g + (q.pos - successor.pos).mag();
+        int qx = q % length;
+        int qy = q / length;
+        bool q_blocked = isBlocked(q);
+        bool q_tight = clearance > 1 && clearance_map.get(q) < clearance;
 
-            // successor.h = distance from goal to successor
-            successor.h = (successor.pos - target).mag();
+        for (int i = 0; i < 8; i++)
+        {
+            int nx = qx + NEIGHBOR_DX[i];
+            int ny = qy + NEIGHBOR_DY[i];
+            if (!inBounds(nx, ny))
+            {
+                continue;
+            }
 
-            // successor.f = successor.g + successor.h
-            successor.f = successor.g + successor.h;
+            int n = toIndex(nx, ny);
+            SearchNode &next = space.nodes[n];
+            if (next.closed == gen)
+            {
+                continue;
+            }
 
-            // Set any nodes containing objects to really high f value
-            if (!network[successor.coords.first][successor.coords.second].objects.empty())
+            // Cost of stepping from n into q, corner included
+            int step = i < 4 ? STRAIGHT_COST : DIAGONAL_COST;
+            if (q_blocked
+                || (i >= 4 && (isBlocked(toIndex(nx, qy)) || isBlocked(toIndex(qx, ny)))))
+            {
+                step += BLOCKED_COST;
+            }
+            else if (q_tight
+                     || (clearance > 1 && i >= 4 && (clearance_map.get(toIndex(nx, qy)) < clearance
+                                                     || clearance_map.get(toIndex(qx, ny)) < clearance)))
             {
-                successor.f += 10000000;
+                step += BLOCKED_COST;
             }
 
-            // if successor is the goal, stop the search
-            if (successor.coords == target_coords)
+            if (current.g > INT_MAX / 2 - step)
             {
-                // Add successor to the closed list
-                network[successor.coords.first][successor.coords.second] = successor;
-                closed_list[&network[successor.coords.first][successor.coords.second]] = true;
+                continue;
+            }
 
-                // Emptying the open list to exit
-                open_list.clear();
-                break;
+            int g = current.g + step;
+            if (next.seen == gen && g >= next.g)
+            {
+                continue;
             }
 
-            bool skip = false;
+            next.g = g;
+            next.parent = q;
+            next.seen = gen;
+
+            int h = boxHeuristic(nx, ny, x0, y0, x1, y1);
+            space.open.push(n, pair<int, int>(g + h, h));
+        }
+    }
+}
+
+/*******************************************************************************
+Jump Point Search. Instead of adding every neighbor to the open list, each
+expanded node only looks in the directions an optimal path could continue in,
+and jumps along each of them until it finds a node where the path may have to
+turn (a jump point). Only jump points go on the open list. Returns false if
+goal can't be reached without crossing an object.
+*******************************************************************************/
+bool Mesh::searchJumpPoints(SearchSpace &space, int start, int goal) const
+{
+    space.begin(length * thickness);
+    unsigned gen = space.generation;
+
+    if (isBlocked(goal))
+    {
+        return false;
+    }
+
+    int h = heuristic(start, goal);
+    SearchNode &first = space.nodes[start];
+    first.g = 0;
+    first.parent = start;
+    first.seen = gen;
+    space.open.push(start, pair<int, int>(h, h));
+
+    while (!space.open.empty())
+    {
+        int q = space.open.pop();
+        SearchNode &current = space.nodes[q];
+        current.closed = gen;
+        space.expanded++;
+
+        if (q == goal)
+        {
+            return true;
+        }
+
+        int qx = q % length;
+        int qy = q / length;
+
+        // Work out which directions are worth jumping in. The start node tries
+        // all of them; other nodes only continue the way they were entered,
+        // plus the turns an obstacle may have forced.
+        int dirs_x[8], dirs_y[8];
+        int num_dirs = 0;
+
+        if (q == start)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                dirs_x[num_dirs] = NEIGHBOR_DX[i];
+                dirs_y[num_dirs] = NEIGHBOR_DY[i];
+                num_dirs++;
+            }
+        }
+        else
+        {
+            int px = current.parent % length;
+            int py = current.parent / length;
+            int dx = (qx > px) - (qx < px);
+            int dy = (qy > py) - (qy < py);
 
-            // If a node with the same position as successor is in the OPEN list
-            // which has a lower f than successor, skip this successor
-            for (size_t j = 0; j < open_list.size(); j++)
+            if (dx && dy)
             {
-                if (open_list[j].coords == successor.coords
-                    && open_list[j].f <= successor.f)
+                dirs_x[num_dirs] = dx; dirs_y[num_dirs] = dy; num_dirs++;
+                dirs_x[num_dirs] = dx; dirs_y[num_dirs] = 0; num_dirs++;
+                dirs_x[num_dirs] = 0; dirs_y[num_dirs] = dy; num_dirs++;
+            }
+            else if (dx)
+            {
+                dirs_x[num_dirs] = dx; dirs_y[num_dirs] = 0; num_dirs++;
+                for (int side = -1; side <= 1; side += 2)
+                {
+                    if (isFree(qx, qy + side))
+                    {
+                        dirs_x[num_dirs] = 0; dirs_y[num_dirs] = side; num_dirs++;
+                        dirs_x[num_dirs] = dx; dirs_y[num_dirs] = side; num_dirs++;
+                    }
+                }
+            }
+            else
+            {
+                dirs_x[num_dirs] = 0; dirs_y[num_dirs] = dy; num_dirs++;
+                for (int side = -1; side <= 1; side += 2)
                 {
-                    skip = true;
-                    break;
+                    if (isFree(qx + side, qy))
+                    {
+                        dirs_x[num_dirs] = side; dirs_y[num_dirs] = 0; num_dirs++;
+                        dirs_x[num_dirs] = side; dirs_y[num_dirs] = dy; num_dirs++;
+                    }
                 }
             }
+        }
+
+        for (int i = 0; i < num_dirs; i++)
+        {
+            int dx = dirs_x[i];
+            int dy = dirs_y[i];
+
+            // Diagonal moves may not cut the corner of an object
+            if (dx && dy && (!isFree(qx + dx, qy) || !isFree(qx, qy + dy)))
+            {
+                continue;
+            }
 
-            // If a node with the same position as successor is in the CLOSED list
-            // which has a lower f than successor, skip this successor
-            if (closed_list.find(&network[successor.coords.first][successor.coords.second]) != closed_list.end()
-                && network[successor.coords.first][successor.coords.second].f <= successor.f)
+            int n = jump(qx + dx, qy + dy, dx, dy, goal);
+            if (n < 0)
             {
-                skip = true;
+                continue;
             }
 
-            // otherwise, add the node to the open list
-            if (!skip)
+            SearchNode &next = space.nodes[n];
+            if (next.closed == gen)
             {
-                open_list.push_back(successor);
+                continue;
+            }
 
-                // FIXME: Node should be added using insertion sort. Inefficient repeated sorting of open list
-                sort(open_list.begin(), open_list.end(), greater<MeshNode>());
+            // Jumps run in straight or diagonal lines, so their cost is
+            // exactly the octile distance
+            int g = current.g + heuristic(q, n);
+            if (next.seen == gen && g >= next.g)
+            {
+                continue;
             }
+
+            next.g = g;
+            next.parent = q;
+            next.seen = gen;
+
+            h = heuristic(n, goal);
+            space.open.push(n, pair<int, int>(g + h, h));
         }
     }
 
-    // Work backwards from target to start to assemble the final path
-    pair<int, int> cur_coords = target_coords;
-    vector<pair<int, int> > path_coords;
+    return false;
+}
 
-    while (cur_coords != start_coords)
+/*******************************************************************************
+Moves from (x, y) in the direction (dx, dy) until reaching a jump point, and
+returns its index, or -1 if an object or the edge of the mesh is hit first.
+Moving straight, a node is a jump point when an object beside the path ends
+there, since a path may need to turn around its end. Moving diagonally, a node
+is a jump point when a straight jump from it finds one.
+*******************************************************************************/
+int Mesh::jump(int x, int y, int dx, int dy, int goal) const
+{
+    while (isFree(x, y))
     {
-        path.push_back(network[cur_coords.first][cur_coords.second].pos);
-        path_coords.push_back(cur_coords);
-        cur_coords = network[cur_coords.first][cur_coords.second].parent;
+        int index = toIndex(x, y);
+        if (index == goal)
+        {
+            return index;
+        }
+
+        if (dx && dy)
+        {
+            if (jump(x + dx, y, dx, 0, goal) >= 0 || jump(x, y + dy, 0, dy, goal) >= 0)
+            {
+                return index;
+            }
+
+            if (!isFree(x + dx, y) || !isFree(x, y + dy))
+            {
+                return -1;
+            }
+        }
+        else if (dx)
+        {
+            if ((isFree(x, y - 1) && !isFree(x - dx, y - 1))
+                || (isFree(x, y + 1) && !isFree(x - dx, y + 1)))
+            {
+                return index;
+            }
+        }
+        else
+        {
+            if ((isFree(x - 1, y) && !isFree(x - 1, y - dy))
+                || (isFree(x + 1, y) && !isFree(x + 1, y - dy)))
+            {
+                return index;
+            }
+        }
+
+        x += dx;
+        y += dy;
     }
 
-    return path;
+    return -1;
+}
+
+// Work backwards from goal to start to assemble the final path. The path is
+// stored goal first, so the next node to move towards is path.back(). Jump
+// Point Search leaves gaps between a node and its parent, so every node along
+// the line between them is filled in.
+void Mesh::buildPath(const SearchSpace &space, int start, int goal, vector<Vector3> &path) const
+{
+    for (int cur = goal; cur != start; cur = space.nodes[cur].parent)
+    {
+        int parent = space.nodes[cur].parent;
+        int x = cur % length, y = cur / length;
+        int px = parent % length, py = parent / length;
+        int dx = (px > x) - (px < x);
+        int dy = (py > y) - (py < y);
+
+        while (x != px || y != py)
+        {
+            path.push_back(getPos(toIndex(x, y)));
+            x += (x != px) * dx;
+            y += (y != py) * dy;
+        }
+    }
 }
 
-// Returns a vector of coordinate pairs representing the coordinates of each
-// node contained within the object
-vector<pair<int, int> > Mesh::getNodesInObject(const GameObject *object) const
+/*******************************************************************************
+String pulling. Walking the path from start, each waypoint is dropped if the
+last waypoint kept can see the one after it. What is left are the corners the
+path bends around. Stretches that go through objects are never shortcut, since
+lineOfSight only passes over free nodes. For wide agents it only passes over
+nodes with at least clearance.
+*******************************************************************************/
+void Mesh::smoothPath(int start, vector<Vector3> &path, int clearance) const
+{
+    if (path.size() < 2)
+    {
+        return;
+    }
+
+    // path is stored goal first, so walk it backwards and write the kept
+    // waypoints back over the end
+    int anchor = start;
+    int kept = path.size();
+    for (int i = path.size() - 1; i > 0; i--)
+    {
+        pair<int, int> next = getIndicesFromPos(path[i - 1]);
+        if (!lineOfSight(anchor, toIndex(next.first, next.second), clearance))
+        {
+            pair<int, int> here = getIndicesFromPos(path[i]);
+            anchor = toIndex(here.first, here.second);
+            path[--kept] = path[i];
+        }
+    }
+    path[--kept] = path[0];
+    path.erase(path.begin(), path.begin() + kept);
+}
+
+// True if every node a straight line between the two nodes touches is free
+bool Mesh::lineOfSight(int from, int to, int clearance) const
+{
+    if (clearance > 1 && clearance_map.isBuilt())
+    {
+        return forEachSpan(from, to, [this, clearance](int y, int x0, int x1) {
+            for (int x = x0; x <= x1; x++)
+            {
+                if (clearance_map.get(toIndex(x, y)) < clearance)
+                {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+    return forEachSpan(from, to, [this](int y, int x0, int x1) {
+        return isSpanFree(y, x0, x1);
+    });
+}
+
+/*******************************************************************************
+Tests a whole run of nodes on one row at once. Nodes are packed row after row,
+so the run is a contiguous range of bits; it is checked a 64-bit word at a
+time, with the partial words at either end masked off.
+*******************************************************************************/
+bool Mesh::isSpanFree(int y, int x0, int x1) const
+{
+    int first = toIndex(x0, y);
+    int last = toIndex(x1, y);
+    int first_word = first >> 6;
+    int last_word = last >> 6;
+
+    uint64_t head = ~(uint64_t)0 << (first & 63);
+    uint64_t tail = ~(uint64_t)0 >> (63 - (last & 63));
+    if (first_word == last_word)
+    {
+        return !(occupancy[first_word] & head & tail);
+    }
+
+    if (occupancy[first_word] & head)
+    {
+        return false;
+    }
+    for (int w = first_word + 1; w < last_word; w++)
+    {
+        if (occupancy[w])
+        {
+            return false;
+        }
+    }
+    return !(occupancy[last_word] & tail);
+}
+
+// Octile distance between two nodes; the cost of the cheapest path between
+// them if nothing is in the way.
+int Mesh::heuristic(int from, int to) const
+{
+    int dx = abs(from % length - to % length);
+    int dy = abs(from / length - to / length);
+    int diagonal = std::min(dx, dy);
+    return DIAGONAL_COST * diagonal + STRAIGHT_COST * (std::max(dx, dy) - diagonal);
+}
+
+// Cost of moving from one node to the adjacent node to, as charged by search
+int Mesh::stepCost(int from, int to) const
+{
+    int fx = from % length, fy = from / length;
+    int tx = to % length, ty = to / length;
+    bool diagonal = fx != tx && fy != ty;
+
+    int step = diagonal ? DIAGONAL_COST : STRAIGHT_COST;
+    if (isBlocked(to)
+        || (diagonal && (isBlocked(toIndex(tx, fy)) || isBlocked(toIndex(fx, ty)))))
+    {
+        step += BLOCKED_COST;
+    }
+    return step;
+}
+
+int Mesh::getNodeIndex(Vector3 pos) const
+{
+    pair<int, int> coords = getIndicesFromPos(pos);
+    return inBounds(coords.first, coords.second) ? toIndex(coords.first, coords.second) : -1;
+}
+
+// Returns the rectangle of nodes contained within the object, clipped to the
+// mesh
+Mesh::Footprint Mesh::getFootprint(const GameObject *object) const
 {
-    vector<pair<int, int> > coordinates;
     Vector3 center = object->getPos();
 
     Vector3 corner1 = center;
@@ -223,15 +1399,12 @@ vector<pair<int, int> > Mesh::getNodesInObject(const GameObject *object) const
     pair<int, int> start_indices = getIndicesFromPos(corner1);
     pair<int, int> end_indices = getIndicesFromPos(corner2);
 
-    for (int i = start_indices.first; i < end_indices.first; i++)
-    {
-        for (int j = start_indices.second; j < end_indices.second; j++)
-        {
-            coordinates.push_back(pair<int, int>(i, j));
-        }
-    }
-
-    return coordinates;
+    Footprint area;
+    area.x0 = std::max(start_indices.first, 0);
+    area.y0 = std::max(start_indices.second, 0);
+    area.x1 = std::min(end_indices.first, length);
+    area.y1 = std::min(end_indices.second, thickness);
+    return area;
 }
 
 // Returns a coordinate pair representing the coordinates of the node
@@ -255,33 +1428,7 @@ Vector3 Mesh::getPosFromIndices(std::pair<int, int> coords) const
     return Vector3(x, y, height);
 }
 
-// Returns coordinates of each node adjacent to the supplied coordinate
-vector<pair<int, int> > Mesh::getNeighbors(pair<int, int> center) const
-{
-    vector<pair<int, int> > neighbors;
-
-    pair<int, int> cards[8];
-    cards[0] = center; cards[0].second--;
-    cards[1] = center; cards[1].first++; cards[1].second--;
-    cards[2] = center; cards[2].first++;
-    cards[3] = center; cards[3].first++; cards[3].second++;
-    cards[4] = center; cards[4].second++;
-    cards[5] = center; cards[5].first--; cards[5].second++;
-    cards[6] = center; cards[6].first--;
-    cards[7] = center; cards[7].first--; cards[7].second--;
-
-    for (int i = 0; i < 8; i++)
-    {
-        if (inBounds(cards[i].first, cards[i].second))
-        {
-            neighbors.push_back(cards[i]);
-        }
-    }
-
-    return neighbors;
-}
-
-// Returns true if x and y are valid indices of the network vector
+// Returns true if x and y are the coordinates of a node
 bool Mesh::inBounds(int x, int y) const
 {
     return (x >= 0 && x < length)
@@ -1,39 +1,119 @@
 #pragma once
-#include "GameObject.h"
-#include <vector>
+#include "FrameArena.h"
+#include "SearchSpace.h"
+#include "MeshHierarchy.h"
+#include "FlowField.h"
+#include "PathBatch.h"
+#include "PathCache.h"
+#include "PathPlanner.h"
+#include "MeshComponents.h"
+#include "ClearanceMap.h"
+#include "Vector3.h"
+#include <climits>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
-struct MeshNode {
-    Vector3 pos;
-    std::vector<const GameObject *> objects;
-    std::pair<int, int> coords; // Coordinates on mesh array
-    std::pair<int, int> parent; // Parent's coordinates on network
-    int f, g, h;
+/***************************************************************************//**
+@enum SearchMode
+Selects the algorithm Mesh::calcPath uses.
+- A_STAR Plain A*. Nodes containing objects are very expensive but can still
+  be crossed, so a path is found even when the target is walled off.
+- JUMP_POINT Jump Point Search. Treats nodes containing objects as walls and
+  every other node as equal cost, and jumps over the long runs of identical
+  nodes that A* would expand one at a time. Paths are as short as A*'s, but in
+  open areas an order of magnitude fewer nodes are expanded. Falls back to A*
+  when the target can't be reached without crossing an object.
+- HIERARCHICAL Hierarchical A* (HPA*) over the clusters built by
+  Mesh::buildHierarchy. Meant for very large meshes; paths are usually a few
+  percent longer than optimal but cost a fraction of a full search. Like
+  JUMP_POINT, only free nodes are walkable, and it falls back to A* when the
+  target can't be reached that way or no hierarchy has been built.
+*******************************************************************************/
+enum SearchMode { A_STAR, JUMP_POINT, HIERARCHICAL };
+
+/***************************************************************************//**
+@enum Unreachable
+Selects what Mesh::calcPath does when no path over free nodes joins start and
+target, which the mesh can tell without searching.
+- CROSS_OBJECTS Search anyway, and return the cheapest path through the objects
+  in the way.
+- GIVE_UP Return an empty path straight away.
+- NEAREST_REACHABLE Return a path to the node nearest the target that can be
+  reached over free nodes instead.
+*******************************************************************************/
+enum Unreachable { CROSS_OBJECTS, GIVE_UP, NEAREST_REACHABLE };
 
-    MeshNode()
+/***************************************************************************//**
+PathOptions collects the settings of a single Mesh::calcPath query. A
+::SearchMode converts to PathOptions, so
+\verbatim
+mesh->calcPath(start, target, JUMP_POINT);
+\endverbatim
+works as expected.
+- mode The ::SearchMode to use. A_STAR by default.
+- any_angle If true, the path is pulled tight after the search: every waypoint
+  that can be skipped by walking in a straight line over free nodes is
+  dropped, so only the turns around objects are left and the path is no longer
+  tied to the 8 grid directions. False by default.
+- unreachable What to do when target can't be reached without crossing an
+  object; see ::Unreachable. CROSS_OBJECTS by default. If the start node itself
+  is covered by an object, the search always runs as if this were
+  CROSS_OBJECTS.
+- radius The radius of the agent, in world units. An agent wider than a node
+  only walks nodes far enough from every object to fit; see
+  Mesh::buildClearance. Searches for such agents always run as A_STAR and are
+  not cached. 0 by default.
+*******************************************************************************/
+struct PathOptions {
+    SearchMode mode;
+    bool any_angle;
+    Unreachable unreachable;
+    float radius;
+
+    PathOptions()
     {
-        coords.first = -1;
-        coords.second = -1;
-        parent.first = -1;
-        parent.second = -1;
-        f = 0; g = 0; h = 0;
+        mode = A_STAR;
+        any_angle = false;
+        unreachable = CROSS_OBJECTS;
+        radius = 0;
     }
 
-    bool operator>(const MeshNode &other) const
+    PathOptions(SearchMode mode)
     {
-        return f > other.f;
+        this->mode = mode;
+        any_angle = false;
+        unreachable = CROSS_OBJECTS;
+        radius = 0;
     }
+
+/***************************************************************************//**
+@fn int getProfile() const
+Packs the options into one number, so that paths found with different options
+are never mixed up by ::PathCache.
+*******************************************************************************/
+    int getProfile() const { return mode | any_angle << 4 | unreachable << 5; }
 };
 
+struct PathPolicy;
+class GameObject;
 
 /***************************************************************************//**
 The Mesh object is composed of a square grid of nodes, and is used for
 pathfinding. Paths between points are calculated using the A* algorithm.
 
-This class is in rough draft. Right now the path will always try to find a way
-around any object. The final version should accept a function object to the
-calculate any miscellanious interest in a node, which would be the value an AI
-assigns to the node based on locations of other GameObjects.
+The open list is an indexed binary heap with decrease-key, and the scores,
+parents and closed flags live in the flat arrays of a ::SearchSpace, so a
+search neither sorts, hashes nor clears anything.\n
+Which nodes are blocked is kept as one bit per node, with a count of the
+objects covering each node beside it, so telling whether a node is blocked is a
+single bit test. The mesh remembers the nodes each object covers; moving an
+object only updates the nodes it moved onto or off of.\n
+By default a path will always try to find a way around any object. To weigh
+nodes differently, pass calcPath a ::PathPolicy; its costs are compiled into
+the search loop.
 *******************************************************************************/
 class Mesh {
     public:
@@ -50,9 +130,29 @@ at 32.
 /***************************************************************************//**
 @fn void insertObject(const GameObject *new_object)
 Inserts a new GameObject pointer onto the mesh. Each node this object overlaps
-will gain a constant pointer to this object.
+is blocked until the object is removed or moves off of it. Inserting an object
+that is already on the mesh is the same as updating it.
+@fn void updateObject(const GameObject *object)
+Call after an inserted object moved or changed size. Only the nodes it moved
+onto or off of are touched, so a moving crate or door costs a few nodes per
+tick instead of rebuilding the mesh.
+@fn void removeObject(const GameObject *object)
+Takes an object off the mesh.
 *******************************************************************************/
         void insertObject(const GameObject *new_object);
+        void updateObject(const GameObject *object);
+        void removeObject(const GameObject *object);
+
+/***************************************************************************//**
+@fn void blockNode(int index)
+Blocks a single node, as if an object covered just that node, for levels that
+come as a grid of walls rather than as objects. Each call counts as one more
+object on the node.
+@fn void unblockNode(int index)
+Undoes one blockNode call on the node.
+*******************************************************************************/
+        void blockNode(int index);
+        void unblockNode(int index);
 
 /***************************************************************************//**
 @fn void clearObjects()
@@ -61,25 +161,443 @@ Removes all object pointers from the mesh.
         void clearObjects();
 
 /***************************************************************************//**
-@fn vector<Vector3> calcPath(Vector3 start, Vector3 target) const
+@fn vector<Vector3> calcPath(Vector3 start, Vector3 target, PathOptions options)
 Returns a vector of Vector3 structs representing the best path to take between
 start and target. Will return an empty vector if start or target are out of
-bounds.
+bounds. The path holds one position per node, starting with the target, so the
+next position to move towards is the back of the vector. A path never cuts
+diagonally past the corner of a node containing an object.
+*******************************************************************************/
+        std::vector<Vector3> calcPath(Vector3 start, Vector3 target, PathOptions options = PathOptions());
+
+/***************************************************************************//**
+@fn void calcPath(Vector3 start, Vector3 target, std::vector<Vector3> &path, PathOptions options)
+Same as the above, but writes the path into \p path. The vector's existing
+capacity is reused, so an agent that keeps its path between searches does not
+allocate once the vector has grown large enough.
+*******************************************************************************/
+        void calcPath(Vector3 start, Vector3 target, std::vector<Vector3> &path, PathOptions options = PathOptions());
+
+/***************************************************************************//**
+@fn void calcPath(Vector3 start, Vector3 target, std::vector<Vector3> &path, const Policy &policy, PathOptions options)
+Runs A* with the step costs and heuristic of policy, a class derived from
+::PathPolicy, such as ::WeightedTerrain or ::PreferCover. The search is
+instantiated for each policy type, so its costs are inlined rather than called
+through a function pointer. options.mode is ignored, since the other modes
+assume every free node costs the same; options.any_angle still straightens the
+path over free nodes. options.radius is ignored; pass ::KeepClearance as the
+policy instead. Results are not cached.
+\verbatim
+mesh->calcPath(start, target, path, WeightedTerrain(mud));
+\endverbatim
+*******************************************************************************/
+        template <class Policy>
+        typename std::enable_if<std::is_base_of<PathPolicy, Policy>::value>::type
+        calcPath(Vector3 start, Vector3 target, std::vector<Vector3> &path, const Policy &policy, PathOptions options = PathOptions());
+
+/***************************************************************************//**
+@fn bool bake(const char *path, uint32_t key)
+Writes which nodes are blocked, along with the component labels and clearance
+if they have been built, to a file Mesh::load can map back in. Meant to be run
+once the level's walls are inserted, ahead of time or on the first run. The
+objects inserted so far become part of the file for good: a loaded mesh does
+not know which object covers which node, so only objects inserted after
+loading can be removed. key is stored with them; make it a hash of whatever
+the level's walls are built from, so a file baked before a wall moved is
+recognized as stale. The hierarchy is not saved. Returns false if the file
+couldn't be written.
+@fn static Mesh *load(const char *path, uint32_t key)
+Maps a file written by bake read-only and returns a new mesh built from it, or
+NULL if the file is missing, was baked with another key or by another version,
+or is damaged. The file holds the mesh's arrays exactly as they are laid out
+in memory, so each is copied out of the mapping in one go, with no parsing and
+nothing done per node.
+*******************************************************************************/
+        bool bake(const char *path, uint32_t key);
+        static Mesh *load(const char *path, uint32_t key);
+
+/***************************************************************************//**
+@fn void buildHierarchy(int cluster_size = 16)
+Builds the abstract graph used by HIERARCHICAL searches, with clusters of
+cluster_size by cluster_size nodes. Only needs to be called once; inserting and
+clearing objects keeps the graph up to date.
+*******************************************************************************/
+        void buildHierarchy(int cluster_size = 16);
+
+/***************************************************************************//**
+@fn void buildComponents()
+Labels which free nodes can reach each other, so unreachable targets are
+answered without a search. Done the first time calcPath is asked for anything
+but CROSS_OBJECTS or isReachable is called; call it up front so ::PathQueue
+searches can use the labels too. Inserting and clearing objects keeps them up
+to date.
+@fn bool isReachable(Vector3 start, Vector3 target)
+Returns true if a path over free nodes joins the nodes nearest start and
+target. Takes constant time once the labels are built.
+*******************************************************************************/
+        void buildComponents();
+        bool isReachable(Vector3 start, Vector3 target);
+
+/***************************************************************************//**
+@fn void buildClearance()
+Calculates how far every node is from the nearest object, which searches with
+a PathOptions::radius need. Done the first time calcPath is given a radius
+wider than a node; call it up front so ::PathQueue searches can use it too.
+Inserting and clearing objects keeps it up to date.
+@fn int getClearance(int index) const
+Returns the clearance of a node: 0 if an object covers it, otherwise the number
+of steps to the nearest such node, diagonal steps included, up to
+ClearanceMap::MAX_CLEARANCE. Before buildClearance, returns 1 for every free
+node.
+@fn int getRequiredClearance(float radius) const
+Returns the clearance a node needs for an agent of radius to stand on it
+without overlapping any node covered by an object.
+*******************************************************************************/
+        void buildClearance();
+        int getClearance(int index) const { return clearance_map.isBuilt() ? clearance_map.get(index) : !isBlocked(index); }
+        int getRequiredClearance(float radius) const;
+
+/***************************************************************************//**
+@fn void calcPath(Vector3 start, Vector3 target, std::vector<Vector3> &path, PathPlanner &planner)
+Same as the A_STAR search above, but keeps its search state in planner between
+calls. An agent that calls this every tick with the same planner only pays for
+the part of the search its own movement and any inserted or cleared objects
+invalidated. Not cached; the planner makes repeated queries cheap already.
+*******************************************************************************/
+        void calcPath(Vector3 start, Vector3 target, std::vector<Vector3> &path, PathPlanner &planner);
+
+/***************************************************************************//**
+@fn void setPathCacheSize(size_t paths)
+Sets how many recent calcPath results are kept for reuse; 128 by default. A
+query that finds its start, target and search mode in the cache is answered
+without searching. 0 turns the cache off.
+@fn const PathCache &getPathCache() const
+Returns the cache, mostly to read its hit and miss counters.
+*******************************************************************************/
+        void setPathCacheSize(size_t paths) { path_cache.setCapacity(paths); }
+        const PathCache &getPathCache() const { return path_cache; }
+
+/***************************************************************************//**
+@fn bool calcFlowField(Vector3 target, FlowField &field)
+Fills field with the direction to step from every node to reach target. Does
+nothing if field already points at the node nearest target and no objects have
+been inserted or cleared since it was filled, so it is safe to call every tick.
+Returns true if the field was recalculated. The field is left unchanged if
+target is out of bounds.
+*******************************************************************************/
+        bool calcFlowField(Vector3 target, FlowField &field);
+
+/***************************************************************************//**
+@fn void calcPaths(const std::vector<Vector3> &starts, Vector3 target, PathBatch &batch, PathOptions options)
+Finds a path from each of starts to target and puts them in batch, in the
+order of starts. One search runs backwards from target and stops as soon as it
+has reached every start, so a squad heading for the same place costs little
+more than a single agent. Paths cost the same as the A_STAR mode; options.mode
+is ignored, options.any_angle, options.unreachable and options.radius are
+honored. Starts that
+NEAREST_REACHABLE sends somewhere other than target are searched on their own.
+Not cached.
+@fn void calcPaths(const std::vector<Vector3> &starts, const std::vector<Vector3> &targets, PathBatch &batch, PathOptions options)
+Same as above, but each start gets a path to whichever of targets is cheapest
+to reach from it.
+*******************************************************************************/
+        void calcPaths(const std::vector<Vector3> &starts, Vector3 target, PathBatch &batch, PathOptions options = PathOptions());
+        void calcPaths(const std::vector<Vector3> &starts, const std::vector<Vector3> &targets, PathBatch &batch, PathOptions options = PathOptions());
+
+/***************************************************************************//**
+@fn unsigned getVersion() const
+Returns a counter that goes up every time objects are inserted or cleared.
+Anything computed from the mesh can remember the version it was computed
+against to tell whether it is out of date.
+*******************************************************************************/
+        unsigned getVersion() const { return version; }
+
+/***************************************************************************//**
+@fn int getNodesExpanded() const
+Returns how many nodes the last call to calcPath or calcFlowField expanded.
+For HIERARCHICAL searches this counts abstract nodes, and it is 0 when the
+path came from the cache.
+*******************************************************************************/
+        int getNodesExpanded() const { return nodes_expanded; }
+
+/***************************************************************************//**
+@var STRAIGHT_COST
+Cost of moving to an orthogonally adjacent node.
+@var DIAGONAL_COST
+Cost of moving to a diagonally adjacent node.
+@var BLOCKED_COST
+Extra cost of entering a node that contains an object. This is large enough
+that a path only goes through an object when there's no way around it.
+*******************************************************************************/
+        static const int STRAIGHT_COST = 100;
+        static const int DIAGONAL_COST = 141;
+        static const int BLOCKED_COST = 1000000;
+
+/***************************************************************************//**
+@fn int getNodeIndex(Vector3 pos) const
+Returns the index of the node nearest pos, which is y * getLength() + x, or -1
+if pos is off the mesh. Policies use node indices to look up per-node data.
+@fn int getLength() const
+Returns the number of nodes in each row.
+@fn int getThickness() const
+Returns the number of rows.
+@fn bool isBlocked(int index) const
+Returns true if any object covers the node.
+@fn int heuristic(int from, int to) const
+Returns the octile distance between two nodes: the cost of the cheapest path
+between them if nothing is in the way.
+@fn int stepCost(int from, int to) const
+Returns the default cost of moving between two adjacent nodes, including
+BLOCKED_COST if the move enters an object or cuts the corner of one.
 *******************************************************************************/
-        std::vector<Vector3> calcPath(Vector3 start, Vector3 target);
+        int getNodeIndex(Vector3 pos) const;
+        int getLength() const { return length; }
+        int getThickness() const { return thickness; }
+        bool isBlocked(int index) const { return (occupancy[index >> 6] >> (index & 63)) & 1; }
+        int heuristic(int from, int to) const;
+        int stepCost(int from, int to) const;
 
     private:
+        friend class MeshHierarchy;
+        friend class MeshComponents;
+        friend class ClearanceMap;
+        friend class PathCache;
+        friend class PathPlanner;
+        friend class PathQueue;
+
+        // For PathQueue, whose snapshots hold only what a search reads
+        Mesh();
+        void copySearchData(const Mesh &mesh);
+
+        bool findPath(SearchSpace &space, int start, int goal, PathOptions options, std::vector<Vector3> &path) const;
+        int resolveGoal(int start, int goal, PathOptions &options) const;
+        template <class Policy> bool search(SearchSpace &space, int start, int goal, const Policy &policy) const;
+        bool searchJumpPoints(SearchSpace &space, int start, int goal) const;
+        int jump(int x, int y, int dx, int dy, int goal) const;
+        void searchBackward(SearchSpace &space, const frame_vector<int> &goals, frame_vector<int> &starts,
+                            int clearance) const;
+        void buildPath(const SearchSpace &space, int start, int goal, std::vector<Vector3> &path) const;
+        void smoothPath(int start, std::vector<Vector3> &path, int clearance = 1) const;
+        bool lineOfSight(int from, int to, int clearance = 1) const;
+        bool isSpanFree(int y, int x0, int x1) const;
+        template <class SpanTest> bool forEachSpan(int from, int to, SpanTest test) const;
+        bool isFree(int x, int y) const { return inBounds(x, y) && !isBlocked(toIndex(x, y)); }
+
+        // Nodes covered by an object, from (x0, y0) up to but not including (x1, y1)
+        struct Footprint {
+            int x0, y0, x1, y1;
+
+            bool contains(int x, int y) const { return x >= x0 && x < x1 && y >= y0 && y < y1; }
+            bool operator==(const Footprint &other) const
+            {
+                return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1;
+            }
+        };
+
+        Footprint getFootprint(const GameObject *object) const;
+        void addToNode(int index, frame_vector<int> &changed);
+        void removeFromNode(int index, frame_vector<int> &changed);
 
-        std::vector<std::pair<int, int> > getNodesInObject(const GameObject *) const;
         std::pair<int, int> getIndicesFromPos(Vector3 pos) const;
         Vector3 getPosFromIndices(std::pair<int, int> coords) const;
-        std::vector<std::pair<int, int> > getNeighbors(std::pair<int, int> center) const;
+        Vector3 getPos(int index) const { return getPosFromIndices(std::pair<int, int>(index % length, index / length)); }
         bool inBounds(int x, int y) const;
+        int toIndex(int x, int y) const { return y * length + x; }
+
+        void markDirty(const frame_vector<int> &nodes);
 
-        std::vector<std::vector<MeshNode> > network;
+        // Offsets to the 8 neighbors of a node, orthogonal ones first
+        static const int NEIGHBOR_DX[8];
+        static const int NEIGHBOR_DY[8];
+        bool getChangesSince(unsigned since, frame_vector<int> &nodes) const;
+
+        // One bit per node, set while any object covers it. Bit i of the mesh is
+        // bit i % 64 of word i / 64.
+        std::vector<uint64_t> occupancy;
+        std::vector<int> refcounts; // Number of objects covering each node
+        std::unordered_map<const GameObject *, Footprint> footprints;
+
+        SearchSpace search_space;
+        MeshHierarchy hierarchy;
+        MeshComponents components;
+        ClearanceMap clearance_map;
+        PathHeap<int> flow_open;
+        PathCache path_cache;
+        int nodes_expanded;
+        unsigned version;
+        std::vector<unsigned> changed_at; // Version at which each node last changed
+        unsigned freed_at; // Version at which any node last became free
+
+        // Nodes that changed, with the version they changed at, oldest first.
+        // Changes up to log_floor may have been dropped to keep it short.
+        std::vector<std::pair<unsigned, int> > change_log;
+        unsigned log_floor;
         int start_x, start_y;
         int height;
         int length, thickness, tiling;
 
-        std::vector<const GameObject *> objects;
-};
\ No newline at end of file
+};
+
+/*******************************************************************************
+Visits the nodes a straight line between the centers of nodes from and to
+passes through or touches, one row at a time. test(y, x0, x1) is called for
+each row with the first and last column touched, and the walk stops early,
+returning false, as soon as test does. A line that passes exactly through the
+corner of a node counts as touching it, so a line may not squeeze between two
+nodes that only meet at a corner, just like a diagonal step may not.\n
+All arithmetic is done on integers in half-node units, so there is no rounding
+to get corner cases wrong.
+*******************************************************************************/
+template <class SpanTest>
+bool Mesh::forEachSpan(int from, int to, SpanTest test) const
+{
+    int x0 = from % length, y0 = from / length;
+    int x1 = to % length, y1 = to / length;
+    if (y0 > y1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+
+    int dx = x1 - x0;
+    int dy = y1 - y0;
+    if (dy == 0)
+    {
+        return test(y0, std::min(x0, x1), std::max(x0, x1));
+    }
+
+    for (int y = y0; y <= y1; y++)
+    {
+        // The part of the line inside this row, in half-node units of y
+        int low = std::max(2 * y - 1, 2 * y0);
+        int high = std::min(2 * y + 1, 2 * y1);
+
+        // 2 * dy times the x of the line at each end of that part
+        int a = 2 * x0 * dy + dx * (low - 2 * y0);
+        int b = 2 * x0 * dy + dx * (high - 2 * y0);
+        if (a > b)
+        {
+            std::swap(a, b);
+        }
+
+        // Columns whose [x - 1/2, x + 1/2] overlaps the line's x range
+        int first = a - dy >= 0 ? (a - dy + 2 * dy - 1) / (2 * dy) : -((dy - a) / (2 * dy));
+        int last = b + dy >= 0 ? (b + dy) / (2 * dy) : -((-(b + dy) + 2 * dy - 1) / (2 * dy));
+        if (!test(y, std::max(first, 0), std::min(last, length - 1)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class Policy>
+typename std::enable_if<std::is_base_of<PathPolicy, Policy>::value>::type
+Mesh::calcPath(Vector3 start, Vector3 target, std::vector<Vector3> &path, const Policy &policy, PathOptions options)
+{
+    path.clear();
+    int start_index = getNodeIndex(start);
+    int target_index = getNodeIndex(target);
+    if (start_index < 0 || target_index < 0)
+    {
+        return;
+    }
+
+    bool found = search(search_space, start_index, target_index, policy);
+    nodes_expanded = search_space.expanded;
+    if (found)
+    {
+        buildPath(search_space, start_index, target_index, path);
+        if (options.any_angle)
+        {
+            smoothPath(start_index, path);
+        }
+    }
+}
+
+/*******************************************************************************
+The A* search itself. The node with the least f is popped off the heap and
+closed, and each neighbor that can be reached more cheaply through it has its g
+and parent updated and its key lowered in place. Ties on f go to the node
+nearer the goal. Each step is first given the default cost, which policy may
+then change. As long as policy's heuristic never overestimates the cost of
+reaching the goal, the first time the goal is popped its path is the cheapest
+one.
+Returns true if goal was reached.
+*******************************************************************************/
+template <class Policy>
+bool Mesh::search(SearchSpace &space, int start, int goal, const Policy &policy) const
+{
+    space.begin(length * thickness);
+    unsigned gen = space.generation;
+
+    int h = policy.heuristic(*this, start, goal);
+    SearchNode &first = space.nodes[start];
+    first.g = 0;
+    first.parent = start;
+    first.seen = gen;
+    space.open.push(start, std::pair<int, int>(h, h));
+
+    while (!space.open.empty())
+    {
+        int q = space.open.pop();
+        SearchNode &current = space.nodes[q];
+        current.closed = gen;
+        space.expanded++;
+
+        if (q == goal)
+        {
+            return true;
+        }
+
+        int qx = q % length;
+        int qy = q / length;
+
+        for (int i = 0; i < 8; i++)
+        {
+            int nx = qx + NEIGHBOR_DX[i];
+            int ny = qy + NEIGHBOR_DY[i];
+            if (!inBounds(nx, ny))
+            {
+                continue;
+            }
+
+            int n = toIndex(nx, ny);
+            SearchNode &next = space.nodes[n];
+            if (next.closed == gen)
+            {
+                continue;
+            }
+
+            // Squeezing diagonally past an object's corner counts as touching it
+            int step = i < 4 ? STRAIGHT_COST : DIAGONAL_COST;
+            if (isBlocked(n)
+                || (i >= 4 && (isBlocked(toIndex(nx, qy)) || isBlocked(toIndex(qx, ny)))))
+            {
+                step += BLOCKED_COST;
+            }
+            step = policy.stepCost(*this, q, n, step);
+
+            // Paths this expensive only come from tunneling through walls
+            if (current.g > INT_MAX / 2 - step)
+            {
+                continue;
+            }
+
+            int g = current.g + step;
+            if (next.seen == gen && g >= next.g)
+            {
+                continue;
+            }
+
+            next.g = g;
+            next.parent = q;
+            next.seen = gen;
+
+            h = policy.heuristic(*this, n, goal);
+            space.open.push(n, std::pair<int, int>(g + h, h));
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,207 @@
+#include "MeshComponents.h"
+#include "Mesh.h"
+#include <algorithm>
+
+// Offsets to the 4 orthogonal neighbors of a node
+static const int NEIGHBOR_DX[4] = { 0, 1, 0, -1 };
+static const int NEIGHBOR_DY[4] = { -1, 0, 1, 0 };
+
+MeshComponents::MeshComponents()
+{
+    generation = 0;
+}
+
+void MeshComponents::build(const Mesh &mesh)
+{
+    int num_nodes = mesh.length * mesh.thickness;
+    parent.resize(num_nodes);
+    rank.assign(num_nodes, 0);
+    is_pending.assign(num_nodes, 0);
+    pending.clear();
+    visited.assign(num_nodes, 0);
+    generation = 1;
+
+    for (int i = 0; i < num_nodes; i++)
+    {
+        parent[i] = i;
+    }
+    for (int i = 0; i < num_nodes; i++)
+    {
+        if (!mesh.isBlocked(i) && visited[i] != generation)
+        {
+            flood(mesh, i);
+        }
+    }
+}
+
+/*******************************************************************************
+Freed nodes are joined with their free neighbors straight away. A node that was
+blocked before the last refresh has nothing pointing at it, so it can start as
+its own root; if it was blocked and freed again since, other nodes may still
+point through it, so it keeps its parent. All of them are reset before any are
+joined, as neighbors freed in the same batch would otherwise undo each other's
+joins. Every changed node is remembered so refresh can re-flood around the ones
+blocked by then.
+*******************************************************************************/
+void MeshComponents::markChanged(const Mesh &mesh, const frame_vector<int> &nodes)
+{
+    if (!isBuilt())
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        int node = nodes[i];
+        if (!is_pending[node])
+        {
+            if (!mesh.isBlocked(node))
+            {
+                parent[node] = node;
+                rank[node] = 0;
+            }
+            is_pending[node] = 1;
+            pending.push_back(node);
+        }
+    }
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        int node = nodes[i];
+        if (mesh.isBlocked(node))
+        {
+            continue;
+        }
+
+        int x = node % mesh.length;
+        int y = node / mesh.length;
+        for (int j = 0; j < 4; j++)
+        {
+            if (mesh.isFree(x + NEIGHBOR_DX[j], y + NEIGHBOR_DY[j]))
+            {
+                join(node, mesh.toIndex(x + NEIGHBOR_DX[j], y + NEIGHBOR_DY[j]));
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+Every area that lost a node touches that node, so flooding outwards from the
+free neighbors of each node blocked since the last refresh relabels all of
+them, and nothing else.
+*******************************************************************************/
+void MeshComponents::refresh(const Mesh &mesh)
+{
+    if (pending.empty())
+    {
+        return;
+    }
+
+    if (++generation == 0)
+    {
+        std::fill(visited.begin(), visited.end(), 0);
+        generation = 1;
+    }
+
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        int node = pending[i];
+        is_pending[node] = 0;
+        if (!mesh.isBlocked(node))
+        {
+            continue;
+        }
+
+        int x = node % mesh.length;
+        int y = node / mesh.length;
+        for (int j = 0; j < 4; j++)
+        {
+            int nx = x + NEIGHBOR_DX[j];
+            int ny = y + NEIGHBOR_DY[j];
+            if (mesh.isFree(nx, ny) && visited[mesh.toIndex(nx, ny)] != generation)
+            {
+                flood(mesh, mesh.toIndex(nx, ny));
+            }
+        }
+    }
+    pending.clear();
+}
+
+int MeshComponents::getComponent(const Mesh &mesh, int node) const
+{
+    if (mesh.isBlocked(node))
+    {
+        return -1;
+    }
+    while (parent[node] != node)
+    {
+        node = parent[node];
+    }
+    return node;
+}
+
+// Root of node's tree, pointing every other node on the way at its grandparent
+int MeshComponents::find(int node)
+{
+    while (parent[node] != node)
+    {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+void MeshComponents::join(int a, int b)
+{
+    a = find(a);
+    b = find(b);
+    if (a == b)
+    {
+        return;
+    }
+
+    if (rank[a] < rank[b])
+    {
+        std::swap(a, b);
+    }
+    parent[b] = a;
+    if (rank[a] == rank[b])
+    {
+        rank[a]++;
+    }
+}
+
+// Labels every free node connected to seed with seed itself
+void MeshComponents::flood(const Mesh &mesh, int seed)
+{
+    queue.clear();
+    queue.push_back(seed);
+    visited[seed] = generation;
+    parent[seed] = seed;
+    rank[seed] = 1;
+
+    for (size_t head = 0; head < queue.size(); head++)
+    {
+        int node = queue[head];
+        int x = node % mesh.length;
+        int y = node / mesh.length;
+        for (int i = 0; i < 4; i++)
+        {
+            int nx = x + NEIGHBOR_DX[i];
+            int ny = y + NEIGHBOR_DY[i];
+            if (!mesh.isFree(nx, ny))
+            {
+                continue;
+            }
+
+            int n = mesh.toIndex(nx, ny);
+            if (visited[n] != generation)
+            {
+                visited[n] = generation;
+                parent[n] = seed;
+                rank[n] = 0;
+                queue.push_back(n);
+            }
+        }
+    }
+}
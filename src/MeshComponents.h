@@ -0,0 +1,63 @@
+#pragma once
+#include "FrameArena.h"
+#include <vector>
+
+class Mesh;
+
+/***************************************************************************//**
+MeshComponents labels the connected areas of free nodes on a ::Mesh, so
+Mesh::calcPath can tell in constant time whether a target can be reached at
+all, instead of searching every node it can reach first.\n
+Paths may not cut corners, so two nodes are connected exactly when a chain of
+free orthogonal neighbors joins them. Labels are kept in a union-find forest:
+a node that becomes free is joined with its free neighbors right away. A node
+that becomes blocked may split its area in two, which is only found out later;
+before the next query, refresh re-floods just the areas that lost nodes.\n
+MeshComponents only stores plain data; every method is handed the mesh it
+labels.
+*******************************************************************************/
+class MeshComponents
+{
+    public:
+        MeshComponents();
+
+/***************************************************************************//**
+@fn void build(const Mesh &mesh)
+Labels every node from scratch.
+@fn bool isBuilt() const
+Returns true once build has been called.
+@fn void markChanged(const Mesh &mesh, const frame_vector<int> &nodes)
+Call after nodes became blocked or free.
+@fn void refresh(const Mesh &mesh)
+Re-floods the areas that lost nodes since the last refresh. Must be called
+before getComponent after any node became blocked.
+*******************************************************************************/
+        void build(const Mesh &mesh);
+        bool isBuilt() const { return !parent.empty(); }
+        void markChanged(const Mesh &mesh, const frame_vector<int> &nodes);
+        void refresh(const Mesh &mesh);
+
+/***************************************************************************//**
+@fn int getComponent(const Mesh &mesh, int node) const
+Returns a label shared by all nodes connected to node, or -1 if node is
+blocked. Only reads the labels, so it is safe to call from several threads.
+*******************************************************************************/
+        int getComponent(const Mesh &mesh, int node) const;
+
+    private:
+        friend class Mesh;
+
+        int find(int node);
+        void join(int a, int b);
+        void flood(const Mesh &mesh, int seed);
+
+        std::vector<int> parent;
+        std::vector<unsigned char> rank;
+
+        std::vector<int> pending;           // Nodes blocked or freed since the last refresh
+        std::vector<unsigned char> is_pending;
+
+        std::vector<unsigned> visited; // Generation in which flood last reached each node
+        unsigned generation;
+        std::vector<int> queue;
+};
@@ -0,0 +1,494 @@
+#include "MeshHierarchy.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <climits>
+using std::pair;
+using std::vector;
+
+// Offsets to the 8 neighbors of a node, orthogonal ones first
+static const int NEIGHBOR_DX[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+static const int NEIGHBOR_DY[8] = { -1, 0, 1, 0, -1, 1, 1, -1 };
+
+// Runs of free border nodes at least this long get an entrance at each end
+// instead of one in the middle
+static const int LONG_TRANSITION = 6;
+
+MeshHierarchy::MeshHierarchy()
+{
+    cluster_size = 0;
+    clusters_x = 0;
+    clusters_y = 0;
+    length = 0;
+    thickness = 0;
+}
+
+/*******************************************************************************
+Lays out the clusters, marks all of them dirty and builds the whole graph.
+*******************************************************************************/
+void MeshHierarchy::build(const Mesh &mesh, int cluster_size)
+{
+    this->cluster_size = std::max(cluster_size, 2);
+    length = mesh.length;
+    thickness = mesh.thickness;
+    clusters_x = (length + this->cluster_size - 1) / this->cluster_size;
+    clusters_y = (thickness + this->cluster_size - 1) / this->cluster_size;
+
+    clusters.clear();
+    clusters.resize(clusters_x * clusters_y);
+    dirty.clear();
+    for (int cy = 0; cy < clusters_y; cy++)
+    {
+        for (int cx = 0; cx < clusters_x; cx++)
+        {
+            Cluster &cluster = clusters[cy * clusters_x + cx];
+            cluster.x0 = cx * this->cluster_size;
+            cluster.y0 = cy * this->cluster_size;
+            cluster.x1 = std::min(cluster.x0 + this->cluster_size, length);
+            cluster.y1 = std::min(cluster.y0 + this->cluster_size, thickness);
+            cluster.dirty = true;
+            dirty.push_back(cy * clusters_x + cx);
+        }
+    }
+
+    entrance_slot.assign(length * thickness, -1);
+    local_cost.resize(this->cluster_size * this->cluster_size);
+    local_parent.resize(this->cluster_size * this->cluster_size);
+    local_open.resize(this->cluster_size * this->cluster_size);
+
+    rebuild(mesh);
+}
+
+void MeshHierarchy::markDirty(int x, int y)
+{
+    if (!isBuilt())
+    {
+        return;
+    }
+
+    int cluster = (y / cluster_size) * clusters_x + x / cluster_size;
+    if (!clusters[cluster].dirty)
+    {
+        clusters[cluster].dirty = true;
+        dirty.push_back(cluster);
+    }
+}
+
+int MeshHierarchy::getNumEntrances() const
+{
+    int total = 0;
+    for (size_t i = 0; i < clusters.size(); i++)
+    {
+        total += clusters[i].entrances.size();
+    }
+    return total;
+}
+
+/*******************************************************************************
+Plans on the abstract graph first. The start and goal are linked to the
+entrances of their clusters (and to each other if they share one), then A* runs
+over the entrances. Each leg of the resulting abstract path is then refined:
+legs across a border are a single step, and legs inside a cluster are found by
+a search confined to that cluster.
+*******************************************************************************/
+bool MeshHierarchy::findPath(const Mesh &mesh, int start, int goal, frame_vector<int> &nodes)
+{
+    rebuild(mesh);
+    space.begin(length * thickness);
+
+    if (start == goal)
+    {
+        return true;
+    }
+    if (mesh.isBlocked(start) || mesh.isBlocked(goal))
+    {
+        return false;
+    }
+
+    int start_cluster = getClusterOf(start);
+    int goal_cluster = getClusterOf(goal);
+    const Cluster &from = clusters[start_cluster];
+    const Cluster &to = clusters[goal_cluster];
+
+    // Link the start and goal into the graph
+    frame_vector<int> start_costs(from.entrances.size(), -1);
+    frame_vector<int> goal_costs(to.entrances.size(), -1);
+    int direct_cost = -1;
+
+    searchCluster(mesh, start_cluster, start, -1);
+    for (size_t i = 0; i < from.entrances.size(); i++)
+    {
+        int cost = local_cost[getLocalIndex(from, from.entrances[i].node)];
+        start_costs[i] = cost == INT_MAX ? -1 : cost;
+    }
+    if (start_cluster == goal_cluster)
+    {
+        int cost = local_cost[getLocalIndex(from, goal)];
+        direct_cost = cost == INT_MAX ? -1 : cost;
+    }
+
+    searchCluster(mesh, goal_cluster, goal, -1);
+    for (size_t i = 0; i < to.entrances.size(); i++)
+    {
+        int cost = local_cost[getLocalIndex(to, to.entrances[i].node)];
+        goal_costs[i] = cost == INT_MAX ? -1 : cost;
+    }
+
+    // A* over the abstract graph
+    unsigned gen = space.generation;
+    int h = mesh.heuristic(start, goal);
+    space.nodes[start].g = 0;
+    space.nodes[start].parent = start;
+    space.nodes[start].seen = gen;
+    space.open.push(start, pair<int, int>(h, h));
+
+    bool found = false;
+    frame_vector<pair<int, int> > edges;
+    while (!space.open.empty())
+    {
+        int q = space.open.pop();
+        SearchNode &current = space.nodes[q];
+        current.closed = gen;
+        space.expanded++;
+
+        if (q == goal)
+        {
+            found = true;
+            break;
+        }
+
+        // Gather the abstract edges leaving q
+        edges.clear();
+        if (q == start)
+        {
+            for (size_t i = 0; i < from.entrances.size(); i++)
+            {
+                if (start_costs[i] >= 0)
+                    edges.push_back(pair<int, int>(from.entrances[i].node, start_costs[i]));
+            }
+            if (direct_cost >= 0)
+            {
+                edges.push_back(pair<int, int>(goal, direct_cost));
+            }
+        }
+        if (entrance_slot[q] >= 0)
+        {
+            int k = getClusterOf(q);
+            const Cluster &cluster = clusters[k];
+            int slot = entrance_slot[q];
+            int count = cluster.entrances.size();
+            for (int j = 0; j < count; j++)
+            {
+                int cost = cluster.costs[slot * count + j];
+                if (j != slot && cost >= 0)
+                    edges.push_back(pair<int, int>(cluster.entrances[j].node, cost));
+            }
+            const Entrance &entrance = cluster.entrances[slot];
+            for (int j = 0; j < entrance.num_partners; j++)
+            {
+                edges.push_back(pair<int, int>(entrance.partners[j], Mesh::STRAIGHT_COST));
+            }
+            if (k == goal_cluster && goal_costs[slot] >= 0)
+            {
+                edges.push_back(pair<int, int>(goal, goal_costs[slot]));
+            }
+        }
+
+        for (size_t i = 0; i < edges.size(); i++)
+        {
+            int n = edges[i].first;
+            SearchNode &next = space.nodes[n];
+            if (next.closed == gen)
+            {
+                continue;
+            }
+
+            int g = current.g + edges[i].second;
+            if (next.seen == gen && g >= next.g)
+            {
+                continue;
+            }
+
+            next.g = g;
+            next.parent = q;
+            next.seen = gen;
+
+            h = mesh.heuristic(n, goal);
+            space.open.push(n, pair<int, int>(g + h, h));
+        }
+    }
+
+    if (!found)
+    {
+        return false;
+    }
+
+    // Refine each leg, working back from the goal
+    for (int cur = goal; cur != start; cur = space.nodes[cur].parent)
+    {
+        int parent = space.nodes[cur].parent;
+        int k = getClusterOf(cur);
+        if (k != getClusterOf(parent))
+        {
+            nodes.push_back(cur);
+            continue;
+        }
+
+        // Search from the parent so walking back from cur runs goal first
+        const Cluster &cluster = clusters[k];
+        searchCluster(mesh, k, parent, cur);
+        int w = cluster.x1 - cluster.x0;
+        int local = getLocalIndex(cluster, cur);
+        int local_start = getLocalIndex(cluster, parent);
+        while (local != local_start)
+        {
+            nodes.push_back(mesh.toIndex(cluster.x0 + local % w, cluster.y0 + local / w));
+            local = local_parent[local];
+        }
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+Rebuilds every dirty cluster and its neighbors. A change inside one cluster
+can move the entrances on its borders, which belong to its neighbors too. The
+entrances are found first so that the costs between them can be linked.
+*******************************************************************************/
+void MeshHierarchy::rebuild(const Mesh &mesh)
+{
+    if (dirty.empty())
+    {
+        return;
+    }
+
+    frame_vector<int> affected;
+    for (size_t i = 0; i < dirty.size(); i++)
+    {
+        int cx = dirty[i] % clusters_x;
+        int cy = dirty[i] / clusters_x;
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                int nx = cx + dx, ny = cy + dy;
+                if ((dx && dy) || nx < 0 || ny < 0 || nx >= clusters_x || ny >= clusters_y)
+                    continue;
+                affected.push_back(ny * clusters_x + nx);
+            }
+        }
+        clusters[dirty[i]].dirty = false;
+    }
+    dirty.clear();
+
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+    for (size_t i = 0; i < affected.size(); i++)
+    {
+        findEntrances(mesh, affected[i]);
+    }
+    for (size_t i = 0; i < affected.size(); i++)
+    {
+        linkEntrances(mesh, affected[i]);
+    }
+}
+
+/*******************************************************************************
+Replaces a cluster's entrances with those found on each of its four borders.
+*******************************************************************************/
+void MeshHierarchy::findEntrances(const Mesh &mesh, int cluster)
+{
+    Cluster &c = clusters[cluster];
+    for (size_t i = 0; i < c.entrances.size(); i++)
+    {
+        entrance_slot[c.entrances[i].node] = -1;
+    }
+    c.entrances.clear();
+
+    int cx = cluster % clusters_x;
+    int cy = cluster / clusters_x;
+    if (cx > 0)
+        findTransitions(mesh, cluster - 1, cluster, false, cluster);
+    if (cx < clusters_x - 1)
+        findTransitions(mesh, cluster, cluster + 1, true, cluster);
+    if (cy > 0)
+        findTransitions(mesh, cluster - clusters_x, cluster, false, cluster);
+    if (cy < clusters_y - 1)
+        findTransitions(mesh, cluster, cluster + clusters_x, true, cluster);
+}
+
+/*******************************************************************************
+Scans the border between cluster a and cluster b, which is to the right of or
+below a, for runs where the nodes on both sides are free. A short run gets one
+transition in its middle; a long one gets one at each end. The side of each
+transition belonging to cluster is added as an entrance; own_first says
+whether that is a's side. The result only depends on which nodes are free, so
+both clusters always agree on where their shared transitions are.
+*******************************************************************************/
+void MeshHierarchy::findTransitions(const Mesh &mesh, int a, int b, bool own_first, int cluster)
+{
+    const Cluster &ca = clusters[a];
+    bool vertical = b == a + 1; // b is to the right, so the border runs down
+
+    int first = vertical ? ca.y0 : ca.x0;
+    int last = vertical ? ca.y1 : ca.x1;
+    int run_start = -1;
+
+    for (int i = first; i <= last; i++)
+    {
+        bool open = false;
+        int na = -1, nb = -1;
+        if (i < last)
+        {
+            int ax = vertical ? ca.x1 - 1 : i;
+            int ay = vertical ? i : ca.y1 - 1;
+            int bx = vertical ? ca.x1 : i;
+            int by = vertical ? i : ca.y1;
+            open = mesh.isFree(ax, ay) && mesh.isFree(bx, by);
+        }
+
+        if (open && run_start < 0)
+        {
+            run_start = i;
+        }
+        else if (!open && run_start >= 0)
+        {
+            int run_end = i - 1;
+            int picks[2];
+            int num_picks = 0;
+            if (run_end - run_start + 1 >= LONG_TRANSITION)
+            {
+                picks[num_picks++] = run_start;
+                picks[num_picks++] = run_end;
+            }
+            else
+            {
+                picks[num_picks++] = (run_start + run_end) / 2;
+            }
+
+            for (int p = 0; p < num_picks; p++)
+            {
+                int j = picks[p];
+                na = vertical ? mesh.toIndex(ca.x1 - 1, j) : mesh.toIndex(j, ca.y1 - 1);
+                nb = vertical ? mesh.toIndex(ca.x1, j) : mesh.toIndex(j, ca.y1);
+                if (own_first)
+                    addEntrance(cluster, na, nb);
+                else
+                    addEntrance(cluster, nb, na);
+            }
+            run_start = -1;
+        }
+    }
+}
+
+// Adds node as an entrance of cluster leading to partner, merging with an
+// existing entrance when node sits on two borders
+void MeshHierarchy::addEntrance(int cluster, int node, int partner)
+{
+    Cluster &c = clusters[cluster];
+    int slot = entrance_slot[node];
+    if (slot < 0)
+    {
+        Entrance entrance;
+        entrance.node = node;
+        entrance.num_partners = 0;
+        slot = c.entrances.size();
+        c.entrances.push_back(entrance);
+        entrance_slot[node] = slot;
+    }
+
+    Entrance &entrance = c.entrances[slot];
+    if (entrance.num_partners < 4)
+    {
+        entrance.partners[entrance.num_partners++] = partner;
+    }
+}
+
+/*******************************************************************************
+Finds the cost between every pair of a cluster's entrances, with one search
+inside the cluster from each entrance.
+*******************************************************************************/
+void MeshHierarchy::linkEntrances(const Mesh &mesh, int cluster)
+{
+    Cluster &c = clusters[cluster];
+    int count = c.entrances.size();
+    c.costs.assign(count * count, -1);
+
+    for (int i = 0; i < count; i++)
+    {
+        searchCluster(mesh, cluster, c.entrances[i].node, -1);
+        for (int j = 0; j < count; j++)
+        {
+            int cost = local_cost[getLocalIndex(c, c.entrances[j].node)];
+            c.costs[i * count + j] = cost == INT_MAX ? -1 : cost;
+        }
+    }
+}
+
+/*******************************************************************************
+Dijkstra's algorithm confined to one cluster, over free nodes only. Fills
+local_cost and local_parent, indexed by position within the cluster. Stops
+early and returns the cost once node to is reached; pass -1 to search the
+whole cluster. Returns -1 if to can't be reached.
+*******************************************************************************/
+int MeshHierarchy::searchCluster(const Mesh &mesh, int cluster, int from, int to)
+{
+    const Cluster &c = clusters[cluster];
+    int w = c.x1 - c.x0;
+    int h = c.y1 - c.y0;
+    std::fill(local_cost.begin(), local_cost.begin() + w * h, INT_MAX);
+    local_open.clear();
+
+    int first = getLocalIndex(c, from);
+    int target = to >= 0 ? getLocalIndex(c, to) : -1;
+    local_cost[first] = 0;
+    local_parent[first] = first;
+    local_open.push(first, 0);
+
+    while (!local_open.empty())
+    {
+        int cost = local_open.topKey();
+        int q = local_open.pop();
+        if (q == target)
+        {
+            return cost;
+        }
+
+        int qx = c.x0 + q % w;
+        int qy = c.y0 + q / w;
+        for (int i = 0; i < 8; i++)
+        {
+            int nx = qx + NEIGHBOR_DX[i];
+            int ny = qy + NEIGHBOR_DY[i];
+            if (nx < c.x0 || nx >= c.x1 || ny < c.y0 || ny >= c.y1 || !mesh.isFree(nx, ny))
+            {
+                continue;
+            }
+            if (i >= 4 && (!mesh.isFree(nx, qy) || !mesh.isFree(qx, ny)))
+            {
+                continue;
+            }
+
+            int n = (ny - c.y0) * w + (nx - c.x0);
+            int next = cost + (i < 4 ? Mesh::STRAIGHT_COST : Mesh::DIAGONAL_COST);
+            if (next < local_cost[n])
+            {
+                local_cost[n] = next;
+                local_parent[n] = q;
+                local_open.push(n, next);
+            }
+        }
+    }
+
+    return -1;
+}
+
+int MeshHierarchy::getClusterOf(int node) const
+{
+    return (node / length / cluster_size) * clusters_x + (node % length) / cluster_size;
+}
+
+int MeshHierarchy::getLocalIndex(const Cluster &cluster, int node) const
+{
+    return (node / length - cluster.y0) * (cluster.x1 - cluster.x0) + (node % length - cluster.x0);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "FrameArena.h"
+#include "SearchSpace.h"
+#include <vector>
+
+class Mesh;
+
+/***************************************************************************//**
+MeshHierarchy is the abstract graph behind hierarchical (HPA*) searches on a
+::Mesh. The mesh is cut into square clusters. Wherever free nodes line up on
+both sides of the border between two clusters, one or two pairs of entrance
+nodes are placed across it. Inside each cluster, the cost of the shortest path
+between every pair of its entrances is stored.\n
+A query connects the start and target to the entrances of their own clusters,
+searches the much smaller graph of entrances, and then only refines the legs of
+that abstract path into nodes, one small search per cluster crossed. Paths are
+not always optimal; they typically run a few percent longer than A* paths.\n
+Like Jump Point Search, only free nodes are walkable and diagonal moves may not
+cut the corner of an object. When objects are inserted or cleared, the clusters
+they touch are marked dirty; before the next query only those clusters and
+their neighbors have their entrances and costs rebuilt.\n
+MeshHierarchy only stores plain data; every method is handed the mesh it
+describes.
+*******************************************************************************/
+class MeshHierarchy
+{
+    public:
+        MeshHierarchy();
+
+/***************************************************************************//**
+@fn void build(const Mesh &mesh, int cluster_size)
+Cuts mesh into clusters of cluster_size by cluster_size nodes and builds the
+whole abstract graph.
+@fn bool isBuilt() const
+Returns true once build has been called.
+@fn void markDirty(int x, int y)
+Notes that the node at (x, y) gained or lost an object, so its cluster needs
+to be rebuilt before the next query.
+*******************************************************************************/
+        void build(const Mesh &mesh, int cluster_size);
+        bool isBuilt() const { return cluster_size > 0; }
+        void markDirty(int x, int y);
+
+/***************************************************************************//**
+@fn bool findPath(const Mesh &mesh, int start, int goal, frame_vector<int> &nodes)
+Fills nodes with the indices of the nodes on a path from start to goal, goal
+first and without start. Returns false if goal can't be reached through free
+nodes.
+@fn int getNodesExpanded() const
+Returns how many abstract nodes the last findPath expanded.
+@fn int getNumEntrances() const
+Returns the number of entrance nodes in the abstract graph.
+*******************************************************************************/
+        bool findPath(const Mesh &mesh, int start, int goal, frame_vector<int> &nodes);
+        int getNodesExpanded() const { return space.expanded; }
+        int getNumEntrances() const;
+
+    private:
+        struct Entrance {
+            int node;        // Index of the entrance node in the mesh
+            int partners[4]; // Entrance nodes across the border in other clusters
+            int num_partners;
+        };
+
+        struct Cluster {
+            int x0, y0, x1, y1; // Nodes covered, x1 and y1 exclusive
+            std::vector<Entrance> entrances;
+            std::vector<int> costs; // Entrance to entrance, -1 if unreachable
+            bool dirty;
+        };
+
+        void rebuild(const Mesh &mesh);
+        void findEntrances(const Mesh &mesh, int cluster);
+        void findTransitions(const Mesh &mesh, int a, int b, bool own_first, int cluster);
+        void addEntrance(int cluster, int node, int partner);
+        void linkEntrances(const Mesh &mesh, int cluster);
+        int searchCluster(const Mesh &mesh, int cluster, int from, int to);
+        int getClusterOf(int node) const;
+        int getLocalIndex(const Cluster &cluster, int node) const;
+
+        int cluster_size, clusters_x, clusters_y;
+        int length, thickness;
+        std::vector<Cluster> clusters;
+        std::vector<int> dirty;
+        std::vector<int> entrance_slot; // Per node; slot in its cluster's entrances, or -1
+
+        SearchSpace space;
+
+        // Scratch space for searches inside a single cluster
+        std::vector<int> local_cost, local_parent;
+        PathHeap<int> local_open;
+};
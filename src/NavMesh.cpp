@@ -0,0 +1,483 @@
+#include "NavMesh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <unordered_map>
+using std::vector;
+
+static float distance(float ax, float ay, float bx, float by)
+{
+    return sqrtf((bx - ax) * (bx - ax) + (by - ay) * (by - ay));
+}
+
+// Positive if b is counterclockwise of a, seen from o
+static float cross(float ox, float oy, float ax, float ay, float bx, float by)
+{
+    return (ax - ox) * (by - oy) - (ay - oy) * (bx - ox);
+}
+
+NavMesh::NavMesh()
+{
+    min_x = min_y = 0;
+    cell_w = cell_h = 1;
+    cells_x = cells_y = 0;
+    nodes_expanded = 0;
+}
+
+/*******************************************************************************
+Every barrier edge splits the area into columns and rows, and the cells they
+form are each wholly free or wholly covered. Free cells are then merged
+greedily: the first unclaimed free cell in reading order grows right as far as
+it can, then down as long as the whole row below it is free and unclaimed.
+Neighboring rectangles are found by walking the cell borders, where two cells
+of different rectangles meet.
+*******************************************************************************/
+void NavMesh::build(const Environment &environment, float x, float y, float width, float height,
+                    float z_min, float z_max, float radius)
+{
+    struct Rect {
+        float x0, y0, x1, y1;
+    };
+
+    vector<Rect> blocks;
+    vector<float> xs(1, x);
+    vector<float> ys(1, y);
+    xs.push_back(x + width);
+    ys.push_back(y + height);
+
+    const vector<GameObject *> &objects = environment.getObjects();
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        const GameObject *object = objects[i];
+        float bottom = object->getPosZ() - object->getDimsZ() / 2;
+        float top = object->getPosZ() + object->getDimsZ() / 2;
+        if (object->getId() != BOUNDRY || top <= z_min || bottom >= z_max)
+        {
+            continue;
+        }
+
+        Rect block;
+        block.x0 = std::max(object->getPosX() - object->getDimsX() / 2 - radius, x);
+        block.y0 = std::max(object->getPosY() - object->getDimsY() / 2 - radius, y);
+        block.x1 = std::min(object->getPosX() + object->getDimsX() / 2 + radius, x + width);
+        block.y1 = std::min(object->getPosY() + object->getDimsY() / 2 + radius, y + height);
+        if (block.x0 < block.x1 && block.y0 < block.y1)
+        {
+            blocks.push_back(block);
+            xs.push_back(block.x0);
+            xs.push_back(block.x1);
+            ys.push_back(block.y0);
+            ys.push_back(block.y1);
+        }
+    }
+
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+    int cols = xs.size() - 1;
+    int rows = ys.size() - 1;
+
+    // -2 for covered cells, -1 for free cells not yet in a rectangle
+    vector<int> owner(cols * rows, -1);
+    for (size_t b = 0; b < blocks.size(); b++)
+    {
+        int i0 = std::lower_bound(xs.begin(), xs.end(), blocks[b].x0) - xs.begin();
+        int i1 = std::lower_bound(xs.begin(), xs.end(), blocks[b].x1) - xs.begin();
+        int j0 = std::lower_bound(ys.begin(), ys.end(), blocks[b].y0) - ys.begin();
+        int j1 = std::lower_bound(ys.begin(), ys.end(), blocks[b].y1) - ys.begin();
+        for (int j = j0; j < j1; j++)
+        {
+            std::fill(owner.begin() + j * cols + i0, owner.begin() + j * cols + i1, -2);
+        }
+    }
+
+    polys.clear();
+    for (int j = 0; j < rows; j++)
+    {
+        for (int i = 0; i < cols; i++)
+        {
+            if (owner[j * cols + i] != -1)
+            {
+                continue;
+            }
+
+            int i1 = i + 1;
+            while (i1 < cols && owner[j * cols + i1] == -1)
+            {
+                i1++;
+            }
+            int j1 = j + 1;
+            while (j1 < rows && std::count(owner.begin() + j1 * cols + i, owner.begin() + j1 * cols + i1, -1) == i1 - i)
+            {
+                j1++;
+            }
+
+            int id = polys.size();
+            for (int jj = j; jj < j1; jj++)
+            {
+                std::fill(owner.begin() + jj * cols + i, owner.begin() + jj * cols + i1, id);
+            }
+
+            Poly poly;
+            poly.x0 = xs[i];
+            poly.y0 = ys[j];
+            poly.x1 = xs[i1];
+            poly.y1 = ys[j1];
+            poly.first_link = poly.num_links = 0;
+            polys.push_back(poly);
+        }
+    }
+
+    // Shared edges, grown one cell border at a time, keyed by the pair of
+    // polygons they join
+    int num_polys = polys.size();
+    vector<Link> edges;
+    vector<int> edge_from;
+    std::unordered_map<long long, int> edge_index;
+    for (int j = 0; j < rows; j++)
+    {
+        for (int i = 0; i < cols; i++)
+        {
+            int a = owner[j * cols + i];
+            for (int side = 0; side < 2; side++)
+            {
+                int ni = i + (side == 0);
+                int nj = j + (side == 1);
+                if (a < 0 || ni >= cols || nj >= rows)
+                {
+                    continue;
+                }
+                int b = owner[nj * cols + ni];
+                if (b < 0 || b == a)
+                {
+                    continue;
+                }
+
+                Link border;
+                border.to = b;
+                border.ax = side == 0 ? xs[ni] : xs[i];
+                border.ay = side == 0 ? ys[j] : ys[nj];
+                border.bx = side == 0 ? xs[ni] : xs[i + 1];
+                border.by = side == 0 ? ys[j + 1] : ys[nj];
+
+                long long key = (long long)a * num_polys + b;
+                auto found = edge_index.find(key);
+                if (found == edge_index.end())
+                {
+                    edge_index[key] = edges.size();
+                    edges.push_back(border);
+                    edge_from.push_back(a);
+                }
+                else
+                {
+                    Link &edge = edges[found->second];
+                    edge.ax = std::min(edge.ax, border.ax);
+                    edge.ay = std::min(edge.ay, border.ay);
+                    edge.bx = std::max(edge.bx, border.bx);
+                    edge.by = std::max(edge.by, border.by);
+                }
+            }
+        }
+    }
+
+    // Each shared edge is a link both ways, stored grouped by polygon
+    for (size_t e = 0; e < edges.size(); e++)
+    {
+        polys[edge_from[e]].num_links++;
+        polys[edges[e].to].num_links++;
+    }
+    int total = 0;
+    for (int p = 0; p < num_polys; p++)
+    {
+        polys[p].first_link = total;
+        total += polys[p].num_links;
+        polys[p].num_links = 0;
+    }
+    links.resize(total);
+    for (size_t e = 0; e < edges.size(); e++)
+    {
+        Poly &from = polys[edge_from[e]];
+        links[from.first_link + from.num_links++] = edges[e];
+
+        Poly &to = polys[edges[e].to];
+        Link back = edges[e];
+        back.to = edge_from[e];
+        links[to.first_link + to.num_links++] = back;
+    }
+
+    // Lookup grid of about one polygon per cell
+    min_x = x;
+    min_y = y;
+    cells_x = cells_y = std::max(1, (int)sqrtf((float)num_polys));
+    cell_w = width / cells_x;
+    cell_h = height / cells_y;
+    cell_start.assign(cells_x * cells_y + 1, 0);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int p = 0; p < num_polys; p++)
+        {
+            int ci0 = std::max(0, std::min((int)((polys[p].x0 - min_x) / cell_w), cells_x - 1));
+            int ci1 = std::max(0, std::min((int)((polys[p].x1 - min_x) / cell_w), cells_x - 1));
+            int cj0 = std::max(0, std::min((int)((polys[p].y0 - min_y) / cell_h), cells_y - 1));
+            int cj1 = std::max(0, std::min((int)((polys[p].y1 - min_y) / cell_h), cells_y - 1));
+            for (int cj = cj0; cj <= cj1; cj++)
+            {
+                for (int ci = ci0; ci <= ci1; ci++)
+                {
+                    if (pass == 0)
+                    {
+                        cell_start[cj * cells_x + ci + 1]++;
+                    }
+                    else
+                    {
+                        cell_polys[cell_start[cj * cells_x + ci]++] = p;
+                    }
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (int c = 0; c < cells_x * cells_y; c++)
+            {
+                cell_start[c + 1] += cell_start[c];
+            }
+            cell_polys.resize(cell_start.back());
+        }
+        else
+        {
+            // Filling moved each start up to the next cell's; shift them back
+            for (int c = cells_x * cells_y; c > 0; c--)
+            {
+                cell_start[c] = cell_start[c - 1];
+            }
+            cell_start[0] = 0;
+        }
+    }
+
+    open.resize(num_polys);
+}
+
+vector<Vector3> NavMesh::calcPath(Vector3 start, Vector3 target)
+{
+    vector<Vector3> path;
+    calcPath(start, target, path);
+    return path;
+}
+
+void NavMesh::calcPath(Vector3 start, Vector3 target, vector<Vector3> &path)
+{
+    path.clear();
+    nodes_expanded = 0;
+
+    Point from = { start.x, start.y };
+    Point to = { target.x, target.y };
+    int start_poly = clamp(from.x, from.y);
+    int goal_poly = clamp(to.x, to.y);
+    if (start_poly < 0 || goal_poly < 0 || !search(start_poly, goal_poly, from, to))
+    {
+        return;
+    }
+
+    funnel(start_poly, goal_poly, from, to, start.z, path);
+
+    // Step out of the barrier first if start was inside one
+    if (from.x != start.x || from.y != start.y)
+    {
+        path.push_back(Vector3(from.x, from.y, start.z));
+    }
+}
+
+// Polygon containing the point, or -1 if it is in a barrier or off the area
+int NavMesh::locate(float x, float y) const
+{
+    if (cells_x == 0 || x < min_x || y < min_y)
+    {
+        return -1;
+    }
+    int ci = std::min((int)((x - min_x) / cell_w), cells_x - 1);
+    int cj = std::min((int)((y - min_y) / cell_h), cells_y - 1);
+
+    int cell = cj * cells_x + ci;
+    for (int i = cell_start[cell]; i < cell_start[cell + 1]; i++)
+    {
+        const Poly &poly = polys[cell_polys[i]];
+        if (x >= poly.x0 && x <= poly.x1 && y >= poly.y0 && y <= poly.y1)
+        {
+            return cell_polys[i];
+        }
+    }
+    return -1;
+}
+
+// Moves the point to the nearest point of any polygon if it isn't in one, and
+// returns that polygon, or -1 if there are none
+int NavMesh::clamp(float &x, float &y) const
+{
+    int found = locate(x, y);
+    if (found >= 0)
+    {
+        return found;
+    }
+
+    float best = FLT_MAX;
+    float best_x = x, best_y = y;
+    for (size_t p = 0; p < polys.size(); p++)
+    {
+        float cx = std::max(polys[p].x0, std::min(x, polys[p].x1));
+        float cy = std::max(polys[p].y0, std::min(y, polys[p].y1));
+        float dist = (cx - x) * (cx - x) + (cy - y) * (cy - y);
+        if (dist < best)
+        {
+            best = dist;
+            best_x = cx;
+            best_y = cy;
+            found = p;
+        }
+    }
+    x = best_x;
+    y = best_y;
+    return found;
+}
+
+/*******************************************************************************
+A* over the polygons. A polygon is entered at the midpoint of the edge it was
+reached through, and each step costs the straight distance from one such point
+to the next; the heuristic is the straight distance to the target. Returns
+false if goal can't be reached from start.
+*******************************************************************************/
+bool NavMesh::search(int start, int goal, Point from, Point to)
+{
+    int num_polys = polys.size();
+    g.assign(num_polys, FLT_MAX);
+    parent.assign(num_polys, -1);
+    parent_link.assign(num_polys, -1);
+    entry.resize(num_polys);
+    closed.assign(num_polys, 0);
+    open.clear();
+
+    g[start] = 0;
+    entry[start] = from;
+    open.push(start, distance(from.x, from.y, to.x, to.y));
+
+    while (!open.empty())
+    {
+        int p = open.pop();
+        closed[p] = 1;
+        nodes_expanded++;
+        if (p == goal)
+        {
+            return true;
+        }
+
+        for (int i = polys[p].first_link; i < polys[p].first_link + polys[p].num_links; i++)
+        {
+            const Link &link = links[i];
+            if (closed[link.to])
+            {
+                continue;
+            }
+
+            Point mid = { (link.ax + link.bx) / 2, (link.ay + link.by) / 2 };
+            float cost = g[p] + distance(entry[p].x, entry[p].y, mid.x, mid.y);
+            if (cost < g[link.to])
+            {
+                g[link.to] = cost;
+                entry[link.to] = mid;
+                parent[link.to] = p;
+                parent_link[link.to] = i;
+                open.push(link.to, cost + distance(mid.x, mid.y, to.x, to.y));
+            }
+        }
+    }
+
+    return false;
+}
+
+/*******************************************************************************
+The funnel (string pulling) algorithm. The corridor of shared edges from start
+to goal is walked while keeping a funnel: an apex, and the left and right
+edges of everything visible from it through the edges so far. Each new edge
+narrows the funnel; once one side would cross over the other, the corner on
+that side is a turn of the path, and becomes the new apex.
+*******************************************************************************/
+void NavMesh::funnel(int start, int goal, Point from, Point to, float z, vector<Vector3> &path)
+{
+    // Edges in travel order as (left, right) pairs, with the start and
+    // target as edges of no width at either end
+    vector<Point> lefts(1, to), rights(1, to);
+    for (int p = goal; p != start; p = parent[p])
+    {
+        // Whichever end is counterclockwise of the way into p is on the left
+        const Link &link = links[parent_link[p]];
+        const Poly &poly = polys[p];
+        float mid_x = (link.ax + link.bx) / 2;
+        float mid_y = (link.ay + link.by) / 2;
+        float dx = (poly.x0 + poly.x1) / 2 - mid_x;
+        float dy = (poly.y0 + poly.y1) / 2 - mid_y;
+        Point a = { link.ax, link.ay };
+        Point b = { link.bx, link.by };
+        bool a_left = dx * (a.y - mid_y) - dy * (a.x - mid_x) > 0;
+        lefts.push_back(a_left ? a : b);
+        rights.push_back(a_left ? b : a);
+    }
+    lefts.push_back(from);
+    rights.push_back(from);
+    std::reverse(lefts.begin(), lefts.end());
+    std::reverse(rights.begin(), rights.end());
+
+    vector<Point> corners;
+    Point apex = from, left = from, right = from;
+    int left_index = 0, right_index = 0;
+    for (int i = 1; i < (int)lefts.size(); i++)
+    {
+        // Narrow the right side, unless that crosses the left side, in which
+        // case the left corner is a turn
+        if (cross(apex.x, apex.y, right.x, right.y, rights[i].x, rights[i].y) >= 0)
+        {
+            if ((apex.x == right.x && apex.y == right.y)
+                || cross(apex.x, apex.y, left.x, left.y, rights[i].x, rights[i].y) < 0)
+            {
+                right = rights[i];
+                right_index = i;
+            }
+            else
+            {
+                corners.push_back(left);
+                apex = right = left;
+                right_index = i = left_index;
+                continue;
+            }
+        }
+
+        if (cross(apex.x, apex.y, left.x, left.y, lefts[i].x, lefts[i].y) <= 0)
+        {
+            if ((apex.x == left.x && apex.y == left.y)
+                || cross(apex.x, apex.y, right.x, right.y, lefts[i].x, lefts[i].y) > 0)
+            {
+                left = lefts[i];
+                left_index = i;
+            }
+            else
+            {
+                corners.push_back(right);
+                apex = left = right;
+                left_index = i = right_index;
+                continue;
+            }
+        }
+    }
+
+    if (to.x != from.x || to.y != from.y)
+    {
+        path.push_back(Vector3(to.x, to.y, z));
+    }
+    for (int i = corners.size() - 1; i >= 0; i--)
+    {
+        if (corners[i].x != to.x || corners[i].y != to.y)
+        {
+            path.push_back(Vector3(corners[i].x, corners[i].y, z));
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "Environment.h"
+#include "PathHeap.h"
+#include "Vector3.h"
+#include <vector>
+
+/***************************************************************************//**
+NavMesh is a polygon alternative to the grid ::Mesh for large levels whose
+walls don't move. The free floor is covered by as few axis-aligned rectangles
+as possible, so a huge arena with a handful of walls is a few hundred polygons
+rather than hundreds of thousands of nodes, and both memory and search time
+grow with how much is in the level, not with its area.\n
+The rectangles are built from the footprints of the ::Barrier objects (those
+with the BOUNDRY id) in an ::Environment, keeping only the barriers that reach
+into a band of heights, so floors and ceilings are left out. The footprints are
+grown by the agent's radius first, so any point in a rectangle is somewhere
+the agent fits.\n
+A path search runs A* over the rectangles, moving through the midpoints of the
+edges they share (portals), then pulls the path tight through the chain of
+portals with the funnel algorithm. Paths are any-angle, in the same form as
+Mesh::calcPath returns. Nothing is updated when barriers move; build the
+NavMesh again.
+\verbatim
+nav.build(environment, 0, 0, WIDTH, HEIGHT, 1, 64, elf->getDimsX() / 2);
+nav.calcPath(elf->getPos(), hero->getPos(), path);
+\endverbatim
+*******************************************************************************/
+class NavMesh
+{
+    public:
+        NavMesh();
+
+/***************************************************************************//**
+@fn void build(const Environment &environment, float x, float y, float width, float height, float z_min, float z_max, float radius)
+Covers the area from (x, y) to (x + width, y + height) with rectangles, leaving
+out the footprint of every barrier in environment that overlaps the heights
+z_min to z_max, grown by radius on every side.
+*******************************************************************************/
+        void build(const Environment &environment, float x, float y, float width, float height,
+                   float z_min, float z_max, float radius = 0);
+
+/***************************************************************************//**
+@fn vector<Vector3> calcPath(Vector3 start, Vector3 target)
+Returns a short path from start to target through the corridor of rectangles
+that A* picks over the midpoints of their shared edges. The funnel pulls the
+path tight within that corridor, but another corridor may be shorter, so the
+path is not always the shortest. It starts with target and leaves out start,
+so the next position to move towards is the back of the vector; each position
+keeps start's height. A start
+or target inside a barrier is moved to the nearest free point first. The path
+is empty if the two can't be joined.
+@fn void calcPath(Vector3 start, Vector3 target, std::vector<Vector3> &path)
+Same as the above, but writes the path into \p path.
+*******************************************************************************/
+        std::vector<Vector3> calcPath(Vector3 start, Vector3 target);
+        void calcPath(Vector3 start, Vector3 target, std::vector<Vector3> &path);
+
+/***************************************************************************//**
+@fn int getNumPolygons() const
+Returns the number of rectangles the floor was split into.
+@fn int getNodesExpanded() const
+Returns how many rectangles the last calcPath expanded.
+*******************************************************************************/
+        int getNumPolygons() const { return polys.size(); }
+        int getNodesExpanded() const { return nodes_expanded; }
+
+    private:
+        struct Poly {
+            float x0, y0, x1, y1;
+            int first_link, num_links; // Range of links leaving this polygon
+        };
+
+        // Edge shared with a neighboring polygon, from (ax, ay) to (bx, by)
+        struct Link {
+            int to;
+            float ax, ay, bx, by;
+        };
+
+        struct Point {
+            float x, y;
+        };
+
+        int locate(float x, float y) const;
+        int clamp(float &x, float &y) const;
+        bool search(int start, int goal, Point from, Point to);
+        void funnel(int start, int goal, Point from, Point to, float z, std::vector<Vector3> &path);
+
+        std::vector<Poly> polys;
+        std::vector<Link> links;
+
+        // Uniform grid over the area listing the polygons overlapping each cell,
+        // so finding the polygon under a point only tests a few
+        float min_x, min_y, cell_w, cell_h;
+        int cells_x, cells_y;
+        std::vector<int> cell_start;
+        std::vector<int> cell_polys;
+
+        // Search scratch, one entry per polygon
+        PathHeap<float> open;
+        std::vector<float> g;
+        std::vector<int> parent;      // Polygon it was reached from
+        std::vector<int> parent_link; // Link it was entered through
+        std::vector<Point> entry;     // Point the polygon was entered at
+        std::vector<char> closed;
+        int nodes_expanded;
+};
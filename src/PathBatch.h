@@ -0,0 +1,55 @@
+#pragma once
+#include "Vector3.h"
+#include <vector>
+
+/***************************************************************************//**
+A PathBatch holds the paths Mesh::calcPaths found for a group of agents. All
+of them share one array of positions, with an offset marking where each path
+starts, so refilling a batch every tick allocates nothing once it has grown to
+fit.\n
+Each path is in the same form as Mesh::calcPath returns: it starts with the
+target and leaves out the agent's own node, so the next position to move
+towards is the last one. A path is empty when its start was off the mesh,
+already at the target, or gave up on an unreachable target.
+\verbatim
+mesh->calcPaths(squad_positions, hero->getPos(), batch);
+for (int i = 0; i < batch.size(); i++)
+{
+    if (!batch.empty(i))
+        squad[i]->moveTowards(batch.getNext(i));
+}
+\endverbatim
+*******************************************************************************/
+class PathBatch
+{
+    public:
+/***************************************************************************//**
+@fn int size() const
+Returns the number of paths, one per start passed to Mesh::calcPaths.
+@fn int getLength(int i) const
+Returns the number of positions in path i.
+@fn bool empty(int i) const
+Returns true if path i has no positions.
+@fn const Vector3 *getPath(int i) const
+Returns the first position of path i; the rest follow it.
+@fn Vector3 getNext(int i) const
+Returns the next position to move towards on path i, which must not be empty.
+@fn void getPath(int i, std::vector<Vector3> &path) const
+Copies path i into path.
+*******************************************************************************/
+        int size() const { return offsets.empty() ? 0 : (int)offsets.size() - 1; }
+        int getLength(int i) const { return offsets[i + 1] - offsets[i]; }
+        bool empty(int i) const { return offsets[i + 1] == offsets[i]; }
+        const Vector3 *getPath(int i) const { return points.data() + offsets[i]; }
+        Vector3 getNext(int i) const { return points[offsets[i + 1] - 1]; }
+        void getPath(int i, std::vector<Vector3> &path) const
+        {
+            path.assign(points.begin() + offsets[i], points.begin() + offsets[i + 1]);
+        }
+
+    private:
+        friend class Mesh;
+
+        std::vector<Vector3> points; // Every path, one after the other
+        std::vector<int> offsets;    // Path i is points[offsets[i]] up to points[offsets[i + 1]]
+};
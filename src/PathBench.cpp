@@ -0,0 +1,282 @@
+/*******************************************************************************
+pathbench measures Mesh::calcPath on the grid maps and scenarios of the Moving
+AI benchmark sets (https://movingai.com/benchmarks/), without Allegro, so
+changes to the search can be timed and checked for regressions.
+\verbatim
+make pathbench
+./pathbench maps/arena.map maps/arena.map.scen [a_star] [jump_point] [hierarchical]
+\endverbatim
+Each mode named (all three by default) runs every query of the scenario file on
+a mesh with one node per map cell and reports per-query latency percentiles,
+nodes expanded, the peak memory the process reached, and how much longer the
+paths were than the scenario's optimal lengths. The path cache is turned off,
+so every query is searched.
+*******************************************************************************/
+
+#include "Mesh.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+using std::string;
+using std::vector;
+
+static const int TILING = 32;
+
+struct Query
+{
+    int start_x, start_y, goal_x, goal_y;
+    double optimal;
+};
+
+// Peak resident memory of the process, in kilobytes
+static long peak_memory()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static double now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*******************************************************************************
+Reads a .map file into a new mesh, blocking every cell that isn't ground ('.'
+or 'G') or swamp ('S'). Returns NULL if the file can't be read or is cut
+short.
+*******************************************************************************/
+static Mesh *load_map(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        return NULL;
+    }
+
+    char type[64];
+    int width = 0, height = 0;
+    if (fscanf(file, " type %63s height %d width %d map", type, &height, &width) != 3
+        || width <= 0 || height <= 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    Mesh *mesh = new Mesh(0, 0, width, height, TILING);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            int cell = fgetc(file);
+            while (cell == '\n' || cell == '\r')
+            {
+                cell = fgetc(file);
+            }
+
+            if (cell == EOF)
+            {
+                fclose(file);
+                delete mesh;
+                return NULL;
+            }
+
+            if (cell != '.' && cell != 'G' && cell != 'S')
+            {
+                mesh->blockNode(y * width + x);
+            }
+        }
+        reset_frame_arena();
+    }
+
+    fclose(file);
+    return mesh;
+}
+
+/*******************************************************************************
+Reads the queries of a .scen file. Each line after the version holds the
+bucket, map name, map size, start, goal and optimal length, tab separated.
+*******************************************************************************/
+static bool load_scenario(const char *path, vector<Query> &queries)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        return false;
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file))
+    {
+        if (strncmp(line, "version", 7) == 0)
+        {
+            continue;
+        }
+
+        Query query;
+        int bucket, width, height;
+        char map[512];
+        if (sscanf(line, "%d %511s %d %d %d %d %d %d %lf", &bucket, map, &width, &height,
+                   &query.start_x, &query.start_y, &query.goal_x, &query.goal_y, &query.optimal) == 9)
+        {
+            queries.push_back(query);
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+// Length of path in cells, from start through every waypoint
+static double path_length(const Query &query, const vector<Vector3> &path)
+{
+    double length = 0;
+    Vector3 from(query.start_x * TILING, query.start_y * TILING, 0);
+    for (int i = path.size() - 1; i >= 0; i--)
+    {
+        Vector3 step = path[i] - from;
+        length += sqrt(step.x * step.x + step.y * step.y) / TILING;
+        from = path[i];
+    }
+    return length;
+}
+
+static double percentile(const vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    return sorted[std::min((size_t)(p * sorted.size()), sorted.size() - 1)];
+}
+
+static void run(Mesh &mesh, const vector<Query> &queries, SearchMode mode, const char *name)
+{
+    vector<double> latencies;
+    vector<Vector3> path;
+    long long expanded = 0;
+    double worst_ratio = 1, total_ratio = 0;
+    int solved = 0, failed = 0, suboptimal = 0;
+
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        const Query &query = queries[i];
+        Vector3 start(query.start_x * TILING, query.start_y * TILING, 0);
+        Vector3 goal(query.goal_x * TILING, query.goal_y * TILING, 0);
+
+        double begin = now();
+        mesh.calcPath(start, goal, path, PathOptions(mode));
+        latencies.push_back((now() - begin) * 1e6);
+        expanded += mesh.getNodesExpanded();
+        reset_frame_arena();
+
+        if (query.optimal <= 0)
+        {
+            continue;
+        }
+
+        double length = path_length(query, path);
+        if (path.empty())
+        {
+            failed++;
+            continue;
+        }
+
+        // Moving AI lengths use sqrt(2) for diagonals, the mesh 1.41, so allow
+        // for the rounding
+        double ratio = length / query.optimal;
+        solved++;
+        total_ratio += ratio;
+        worst_ratio = std::max(worst_ratio, ratio);
+        if (ratio > 1.001)
+        {
+            suboptimal++;
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0;
+    for (size_t i = 0; i < latencies.size(); i++)
+    {
+        total += latencies[i];
+    }
+
+    printf("%s\n", name);
+    printf("  queries        %d (%d failed)\n", (int)queries.size(), failed);
+    printf("  latency (us)   mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+           latencies.empty() ? 0 : total / latencies.size(), percentile(latencies, 0.5),
+           percentile(latencies, 0.9), percentile(latencies, 0.99), percentile(latencies, 1));
+    printf("  expanded       mean %.1f  total %lld\n",
+           queries.empty() ? 0 : (double)expanded / queries.size(), expanded);
+    printf("  optimality     mean %.4f  worst %.4f  suboptimal %d\n",
+           solved ? total_ratio / solved : 1, worst_ratio, suboptimal);
+    printf("  peak memory    %ld KB\n", peak_memory());
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s file.map file.scen [a_star] [jump_point] [hierarchical]\n", argv[0]);
+        return 1;
+    }
+
+    long memory_before = peak_memory();
+    double begin = now();
+    Mesh *mesh = load_map(argv[1]);
+    if (!mesh)
+    {
+        fprintf(stderr, "could not read map %s\n", argv[1]);
+        return 1;
+    }
+    mesh->setPathCacheSize(0);
+    printf("map            %s, %d x %d, loaded in %.1f ms, %ld KB\n", argv[1], mesh->getLength(),
+           mesh->getThickness(), (now() - begin) * 1e3, peak_memory() - memory_before);
+
+    vector<Query> queries;
+    if (!load_scenario(argv[2], queries))
+    {
+        fprintf(stderr, "could not read scenario %s\n", argv[2]);
+        delete mesh;
+        return 1;
+    }
+
+    vector<string> modes(argv + 3, argv + argc);
+    if (modes.empty())
+    {
+        modes.push_back("a_star");
+        modes.push_back("jump_point");
+        modes.push_back("hierarchical");
+    }
+
+    for (size_t i = 0; i < modes.size(); i++)
+    {
+        if (modes[i] == "a_star")
+        {
+            run(*mesh, queries, A_STAR, "a_star");
+        }
+        else if (modes[i] == "jump_point")
+        {
+            run(*mesh, queries, JUMP_POINT, "jump_point");
+        }
+        else if (modes[i] == "hierarchical")
+        {
+            begin = now();
+            mesh->buildHierarchy();
+            printf("hierarchy built in %.1f ms\n", (now() - begin) * 1e3);
+            run(*mesh, queries, HIERARCHICAL, "hierarchical");
+        }
+        else
+        {
+            fprintf(stderr, "unknown mode %s\n", modes[i].c_str());
+        }
+    }
+
+    delete mesh;
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include "PathCache.h"
+#include "Mesh.h"
+using std::vector;
+using std::pair;
+
+PathCache::PathCache(size_t capacity)
+{
+    this->capacity = capacity;
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+}
+
+PathCache::PathCache(const PathCache &other)
+    : capacity(other.capacity), hits(other.hits), misses(other.misses),
+      evictions(other.evictions), entries(other.entries)
+{
+    rebuildIndex();
+}
+
+PathCache &PathCache::operator=(const PathCache &other)
+{
+    if (this != &other)
+    {
+        capacity = other.capacity;
+        hits = other.hits;
+        misses = other.misses;
+        evictions = other.evictions;
+        entries = other.entries;
+        rebuildIndex();
+    }
+    return *this;
+}
+
+/*******************************************************************************
+Looks the path up and moves it to the front of the list. If the mesh changed
+since the path was last checked, it is checked again before being handed out;
+a path through objects is dropped instead if any node became free since.
+*******************************************************************************/
+const vector<Vector3> *PathCache::find(const Mesh &mesh, int start, int goal, int profile)
+{
+    Key key = { start, goal, profile };
+    auto found = index.find(key);
+    if (found == index.end())
+    {
+        misses++;
+        return NULL;
+    }
+
+    std::list<Entry>::iterator entry = found->second;
+    if (entry->version != mesh.version)
+    {
+        if ((entry->through_objects && mesh.freed_at > entry->version) || !isCurrent(mesh, *entry))
+        {
+            index.erase(found);
+            entries.erase(entry);
+            evictions++;
+            misses++;
+            return NULL;
+        }
+        entry->version = mesh.version;
+    }
+
+    entries.splice(entries.begin(), entries, entry);
+    hits++;
+    return &entry->path;
+}
+
+void PathCache::insert(const Mesh &mesh, int start, int goal, int profile, const vector<Vector3> &path)
+{
+    if (capacity == 0)
+    {
+        return;
+    }
+
+    Key key = { start, goal, profile };
+    auto found = index.find(key);
+    if (found != index.end())
+    {
+        entries.splice(entries.begin(), entries, found->second);
+    }
+    else
+    {
+        if (entries.size() >= capacity)
+        {
+            evictBack();
+        }
+        entries.push_front(Entry());
+        entries.front().key = key;
+        index[key] = entries.begin();
+    }
+
+    entries.front().version = mesh.version;
+    entries.front().through_objects = crossesObjects(mesh, start, path);
+    entries.front().path = path;
+}
+
+void PathCache::setCapacity(size_t capacity)
+{
+    this->capacity = capacity;
+    while (entries.size() > capacity)
+    {
+        evictBack();
+    }
+}
+
+void PathCache::clear()
+{
+    entries.clear();
+    index.clear();
+}
+
+/*******************************************************************************
+Walks the path from its start and returns false if any node it passes over
+gained or lost an object after the entry was last checked. Each leg is traced
+as a straight line, which covers both the corners squeezed past by diagonal
+steps and the nodes crossed by the long legs of any-angle paths.
+*******************************************************************************/
+bool PathCache::isCurrent(const Mesh &mesh, const Entry &entry) const
+{
+    unsigned checked = entry.version;
+    auto unchanged = [&mesh, checked](int y, int x0, int x1) {
+        for (int x = x0; x <= x1; x++)
+        {
+            if (mesh.changed_at[mesh.toIndex(x, y)] > checked)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    int from = entry.key.start;
+    for (int i = entry.path.size() - 1; i >= 0; i--)
+    {
+        pair<int, int> xy = mesh.getIndicesFromPos(entry.path[i]);
+        int to = mesh.toIndex(xy.first, xy.second);
+        if (!mesh.forEachSpan(from, to, unchanged))
+        {
+            return false;
+        }
+        from = to;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+Returns true if any leg of path, traced like isCurrent traces it, touches a
+blocked node. Such a path was only found because no free route existed.
+*******************************************************************************/
+bool PathCache::crossesObjects(const Mesh &mesh, int start, const vector<Vector3> &path)
+{
+    auto is_free = [&mesh](int y, int x0, int x1) { return mesh.isSpanFree(y, x0, x1); };
+
+    int from = start;
+    for (int i = path.size() - 1; i >= 0; i--)
+    {
+        pair<int, int> xy = mesh.getIndicesFromPos(path[i]);
+        int to = mesh.toIndex(xy.first, xy.second);
+        if (!mesh.forEachSpan(from, to, is_free))
+        {
+            return true;
+        }
+        from = to;
+    }
+
+    return false;
+}
+
+// The index holds iterators into entries, so a copied list needs a new index
+void PathCache::rebuildIndex()
+{
+    index.clear();
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        index[it->key] = it;
+    }
+}
+
+void PathCache::evictBack()
+{
+    index.erase(entries.back().key);
+    entries.pop_back();
+    evictions++;
+}
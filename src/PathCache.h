@@ -0,0 +1,116 @@
+#pragma once
+#include "Vector3.h"
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+class Mesh;
+
+/***************************************************************************//**
+PathCache remembers the results of recent Mesh::calcPath queries, so agents
+that keep asking for the same path don't search for it again. Entries are
+keyed by start node, target node and cost profile (the ::SearchMode), and the
+least recently used entry is dropped once the cache is full.\n
+Each entry is tagged with the Mesh::getVersion it was last known to be good
+at. The mesh also records the version at which each node last gained or lost
+an object. When an entry is looked up after the mesh has changed, the nodes
+its path steps on and the corners it passes are checked against those
+versions. If none of them changed, the entry is tagged with the current
+version and returned; otherwise it is evicted. Paths that stay clear of the
+change survive, at the cost of not noticing shortcuts opened up elsewhere by
+clearing objects. The exception is a path forced through objects because no
+free route existed: clearing any node may open one, so such a path is evicted
+as soon as any node becomes free.\n
+PathCache only stores plain data; every method is handed the mesh it caches
+paths for.
+*******************************************************************************/
+class PathCache
+{
+    public:
+/***************************************************************************//**
+@fn PathCache(size_t capacity)
+Creates a cache holding at most capacity paths. A capacity of 0 disables it.
+*******************************************************************************/
+        PathCache(size_t capacity = 128);
+
+/***************************************************************************//**
+@fn PathCache(const PathCache &other)
+Copies other's paths and counters, so a copied ::Mesh keeps a working cache.
+*******************************************************************************/
+        PathCache(const PathCache &other);
+        PathCache &operator=(const PathCache &other);
+
+/***************************************************************************//**
+@fn const std::vector<Vector3> *find(const Mesh &mesh, int start, int goal, int profile)
+Returns the cached path between the start and goal nodes, or NULL if there is
+none or it crosses nodes that changed since it was cached.
+@fn void insert(const Mesh &mesh, int start, int goal, int profile, const std::vector<Vector3> &path)
+Caches path, evicting the least recently used path if the cache is full.
+*******************************************************************************/
+        const std::vector<Vector3> *find(const Mesh &mesh, int start, int goal, int profile);
+        void insert(const Mesh &mesh, int start, int goal, int profile, const std::vector<Vector3> &path);
+
+/***************************************************************************//**
+@fn void setCapacity(size_t capacity)
+Changes the number of paths the cache can hold, dropping the least recently
+used ones if it shrinks.
+@fn void clear()
+Drops every cached path.
+*******************************************************************************/
+        void setCapacity(size_t capacity);
+        void clear();
+
+/***************************************************************************//**
+@fn size_t size() const
+Returns the number of paths in the cache.
+@fn size_t getHits() const
+Returns the number of lookups that found a usable path.
+@fn size_t getMisses() const
+Returns the number of lookups that found nothing or a stale path.
+@fn size_t getEvictions() const
+Returns the number of paths dropped, either because they went stale or to
+make room.
+*******************************************************************************/
+        size_t size() const { return entries.size(); }
+        size_t getHits() const { return hits; }
+        size_t getMisses() const { return misses; }
+        size_t getEvictions() const { return evictions; }
+
+    private:
+        struct Key {
+            int start, goal, profile;
+
+            bool operator==(const Key &other) const
+            {
+                return start == other.start && goal == other.goal && profile == other.profile;
+            }
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key &key) const
+            {
+                size_t h = key.start;
+                h = h * 1000003u ^ key.goal;
+                return h * 1000003u ^ key.profile;
+            }
+        };
+
+        struct Entry {
+            Key key;
+            unsigned version; // Mesh version the path was last checked against
+            bool through_objects; // Whether the path crosses or cuts past an object
+            std::vector<Vector3> path;
+        };
+
+        bool isCurrent(const Mesh &mesh, const Entry &entry) const;
+        static bool crossesObjects(const Mesh &mesh, int start, const std::vector<Vector3> &path);
+        void rebuildIndex();
+        void evictBack();
+
+        size_t capacity;
+        size_t hits, misses, evictions;
+
+        std::list<Entry> entries; // Most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+};
@@ -0,0 +1,74 @@
+/*******************************************************************************
+pathcachetest checks that Mesh::calcPath never hands out a cached path that a
+fresh search would no longer return. Run it with make check; it prints each
+failure and exits non-zero if there was any.
+*******************************************************************************/
+
+#include "Mesh.h"
+#include <cstdio>
+#include <vector>
+using std::vector;
+
+static const int LENGTH = 20;
+static const int THICKNESS = 10;
+static const int TILING = 32;
+
+static int failures = 0;
+
+static void check(bool passed, const char *what)
+{
+    if (!passed)
+    {
+        printf("FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+// Position of the node in column x, row y
+static Vector3 node_pos(int x, int y)
+{
+    return Vector3(x * TILING, y * TILING, 0);
+}
+
+static bool crosses_objects(const Mesh &mesh, const vector<Vector3> &path)
+{
+    for (size_t i = 0; i < path.size(); i++)
+    {
+        if (mesh.isBlocked(mesh.getNodeIndex(path[i])))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*******************************************************************************
+A wall splits the mesh, so the first query can only be answered by a path
+through it, which gets cached. A gap is then opened at the far end of the wall,
+away from every node on that path. The second query must take the gap instead
+of getting the cached path through the wall back.
+*******************************************************************************/
+static void test_gap_opened_away_from_path()
+{
+    Mesh mesh(0, 0, LENGTH, THICKNESS, TILING);
+    for (int y = 0; y < THICKNESS; y++)
+    {
+        mesh.blockNode(mesh.getNodeIndex(node_pos(LENGTH / 2, y)));
+    }
+
+    vector<Vector3> path;
+    mesh.calcPath(node_pos(2, THICKNESS / 2), node_pos(LENGTH - 3, THICKNESS / 2), path);
+    check(!path.empty(), "walled off target is reached through the wall");
+    check(crosses_objects(mesh, path), "first path crosses the wall");
+
+    mesh.unblockNode(mesh.getNodeIndex(node_pos(LENGTH / 2, 0)));
+    mesh.calcPath(node_pos(2, THICKNESS / 2), node_pos(LENGTH - 3, THICKNESS / 2), path);
+    check(!path.empty(), "target is reached through the gap");
+    check(!crosses_objects(mesh, path), "path after opening a gap is free of objects");
+}
+
+int main()
+{
+    test_gap_opened_away_from_path();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+
+/***************************************************************************//**
+PathHeap is an indexed binary min-heap of mesh node indices, used as the open
+list of ::Mesh searches. Each node can be in the heap at most once, and knows
+its slot in the heap, so a node's key can be lowered in place (decrease-key)
+instead of pushing a duplicate and searching for it later.\n
+Slots are stamped with a generation number. PathHeap::clear only bumps the
+generation, so starting a new search costs nothing no matter how large the
+mesh is.\n
+Key can be any type with operator<, such as an int or a std::pair of ints.
+*******************************************************************************/
+template <class Key>
+class PathHeap
+{
+    public:
+        PathHeap() { generation = 1; }
+
+/***************************************************************************//**
+@fn void resize(int num_nodes)
+Makes room for node indices 0 to num_nodes - 1 and empties the heap.
+@fn void clear()
+Empties the heap.
+*******************************************************************************/
+        void resize(int num_nodes)
+        {
+            position.assign(num_nodes, -1);
+            stamp.assign(num_nodes, 0);
+            generation = 1;
+            heap.clear();
+        }
+
+        void clear()
+        {
+            heap.clear();
+            if (++generation == 0)
+            {
+                std::fill(stamp.begin(), stamp.end(), 0);
+                generation = 1;
+            }
+        }
+
+/***************************************************************************//**
+@fn bool empty() const
+Returns true if no nodes are in the heap.
+@fn int size() const
+Returns the number of nodes in the heap.
+@fn bool contains(int node) const
+Returns true if node is currently in the heap.
+@fn int top() const
+Returns the node with the least key without removing it.
+@fn const Key &topKey() const
+Returns the least key in the heap.
+*******************************************************************************/
+        bool empty() const { return heap.empty(); }
+        int size() const { return heap.size(); }
+        bool contains(int node) const { return stamp[node] == generation && position[node] >= 0; }
+        int top() const { return heap[0].node; }
+        const Key &topKey() const { return heap[0].key; }
+
+/***************************************************************************//**
+@fn void push(int node, const Key &key)
+Inserts node, or changes its key if it is already in the heap.
+@fn int pop()
+Removes and returns the node with the least key.
+@fn void remove(int node)
+Removes node if it is in the heap.
+*******************************************************************************/
+        void push(int node, const Key &key)
+        {
+            if (contains(node))
+            {
+                int i = position[node];
+                bool lowered = key < heap[i].key;
+                heap[i].key = key;
+                if (lowered)
+                    siftUp(i);
+                else
+                    siftDown(i);
+                return;
+            }
+
+            stamp[node] = generation;
+            heap.push_back(Entry(key, node));
+            siftUp(heap.size() - 1);
+        }
+
+        int pop()
+        {
+            int node = heap[0].node;
+            removeAt(0);
+            return node;
+        }
+
+        void remove(int node)
+        {
+            if (contains(node))
+            {
+                removeAt(position[node]);
+            }
+        }
+
+    private:
+        struct Entry
+        {
+            Key key;
+            int node;
+
+            Entry(const Key &key, int node) : key(key), node(node) {}
+        };
+
+        void removeAt(int i)
+        {
+            position[heap[i].node] = -1;
+            Entry last = heap.back();
+            heap.pop_back();
+            if (i < (int)heap.size())
+            {
+                heap[i] = last;
+                position[last.node] = i;
+                if (i > 0 && last.key < heap[(i - 1) / 2].key)
+                    siftUp(i);
+                else
+                    siftDown(i);
+            }
+        }
+
+        // Moves the entry at i up until its parent's key is no greater
+        void siftUp(int i)
+        {
+            Entry moving = heap[i];
+            while (i > 0)
+            {
+                int parent = (i - 1) / 2;
+                if (!(moving.key < heap[parent].key))
+                    break;
+                heap[i] = heap[parent];
+                position[heap[i].node] = i;
+                i = parent;
+            }
+            heap[i] = moving;
+            position[moving.node] = i;
+        }
+
+        // Moves the entry at i down until both children have keys no less
+        void siftDown(int i)
+        {
+            Entry moving = heap[i];
+            int n = heap.size();
+            while (true)
+            {
+                int child = 2 * i + 1;
+                if (child >= n)
+                    break;
+                if (child + 1 < n && heap[child + 1].key < heap[child].key)
+                    child++;
+                if (!(heap[child].key < moving.key))
+                    break;
+                heap[i] = heap[child];
+                position[heap[i].node] = i;
+                i = child;
+            }
+            heap[i] = moving;
+            position[moving.node] = i;
+        }
+
+        std::vector<Entry> heap;
+        std::vector<int> position;
+        std::vector<unsigned> stamp;
+        unsigned generation;
+};
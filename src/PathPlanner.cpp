@@ -0,0 +1,263 @@
+#include "PathPlanner.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <climits>
+using std::pair;
+
+// Offsets to the 8 neighbors of a node, orthogonal ones first
+static const int NEIGHBOR_DX[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+static const int NEIGHBOR_DY[8] = { -1, 0, 1, 0, -1, 1, 1, -1 };
+
+// Costs are INT_MAX when unknown; sums saturate rather than overflow
+static int addCost(int a, int b)
+{
+    return a >= INT_MAX - b ? INT_MAX : a + b;
+}
+
+PathPlanner::PathPlanner()
+{
+    reset();
+}
+
+void PathPlanner::reset()
+{
+    start = -1;
+    goal = -1;
+    last_start = -1;
+    km = 0;
+    version = 0;
+    num_nodes = 0;
+    expanded = 0;
+}
+
+/*******************************************************************************
+Brings the search up to date with the agent's new start and any changes to the
+mesh, finishes the search, then follows the cheapest neighbors from start to
+goal.
+*******************************************************************************/
+bool PathPlanner::findPath(const Mesh &mesh, int start, int goal, frame_vector<int> &nodes)
+{
+    expanded = 0;
+    if (num_nodes != mesh.length * mesh.thickness || goal != this->goal)
+    {
+        initialize(mesh, start, goal);
+    }
+    else
+    {
+        // Keys already in the heap were computed from the old start. Rather
+        // than recomputing them all, later keys are raised by how far the
+        // heuristic can have shifted.
+        if (start != last_start)
+        {
+            km = addCost(km, mesh.heuristic(last_start, start));
+            last_start = start;
+        }
+        this->start = start;
+        applyChanges(mesh);
+    }
+
+    computePath(mesh);
+    if (rhs[start] == INT_MAX)
+    {
+        return false;
+    }
+
+    int current = start;
+    for (int steps = 0; current != goal; steps++)
+    {
+        int next;
+        if (steps == num_nodes || lookahead(mesh, current, &next) == INT_MAX)
+        {
+            nodes.clear();
+            return false;
+        }
+        nodes.push_back(next);
+        current = next;
+    }
+
+    std::reverse(nodes.begin(), nodes.end());
+    return true;
+}
+
+void PathPlanner::initialize(const Mesh &mesh, int start, int goal)
+{
+    this->start = start;
+    this->goal = goal;
+    last_start = start;
+    km = 0;
+    version = mesh.version;
+    num_nodes = mesh.length * mesh.thickness;
+
+    g.assign(num_nodes, INT_MAX);
+    rhs.assign(num_nodes, INT_MAX);
+    open.resize(num_nodes);
+
+    rhs[goal] = 0;
+    open.push(goal, calcKey(mesh, goal));
+}
+
+/*******************************************************************************
+A node that gained or lost an object changes the cost of every move into it,
+and of the diagonal moves that squeeze past it. All of those moves start at one
+of its neighbors, so only the neighbors need their lookahead recomputed. If the
+mesh has forgotten some of the changes, the search starts over.
+*******************************************************************************/
+void PathPlanner::applyChanges(const Mesh &mesh)
+{
+    if (version == mesh.version)
+    {
+        return;
+    }
+
+    frame_vector<int> changed;
+    if (!mesh.getChangesSince(version, changed))
+    {
+        initialize(mesh, start, goal);
+        return;
+    }
+    version = mesh.version;
+
+    for (size_t i = 0; i < changed.size(); i++)
+    {
+        int x = changed[i] % mesh.length;
+        int y = changed[i] / mesh.length;
+        for (int j = 0; j < 8; j++)
+        {
+            if (mesh.inBounds(x + NEIGHBOR_DX[j], y + NEIGHBOR_DY[j]))
+            {
+                updateNode(mesh, mesh.toIndex(x + NEIGHBOR_DX[j], y + NEIGHBOR_DY[j]));
+            }
+        }
+    }
+}
+
+// Recomputes the lookahead of node and puts it on or takes it off the open
+// list depending on whether it is still consistent
+void PathPlanner::updateNode(const Mesh &mesh, int node)
+{
+    if (node != goal)
+    {
+        rhs[node] = lookahead(mesh, node, NULL);
+    }
+
+    if (g[node] != rhs[node])
+    {
+        open.push(node, calcKey(mesh, node));
+    }
+    else
+    {
+        open.remove(node);
+    }
+}
+
+/*******************************************************************************
+The D* Lite main loop. Nodes are expanded in key order until start is
+consistent and nothing on the open list could still improve it. An
+overconsistent node (g above rhs) has its g lowered and can only lower its
+neighbors' lookaheads. An underconsistent one has its g raised to unknown, and
+every neighbor whose lookahead went through it is recomputed.
+*******************************************************************************/
+void PathPlanner::computePath(const Mesh &mesh)
+{
+    while (!open.empty()
+           && (open.topKey() < calcKey(mesh, start) || rhs[start] > g[start]))
+    {
+        int u = open.top();
+        Key old_key = open.topKey();
+        Key new_key = calcKey(mesh, u);
+        if (old_key < new_key)
+        {
+            open.push(u, new_key);
+            continue;
+        }
+
+        expanded++;
+        int ux = u % mesh.length;
+        int uy = u / mesh.length;
+
+        if (g[u] > rhs[u])
+        {
+            g[u] = rhs[u];
+            open.remove(u);
+            for (int i = 0; i < 8; i++)
+            {
+                int sx = ux + NEIGHBOR_DX[i];
+                int sy = uy + NEIGHBOR_DY[i];
+                if (!mesh.inBounds(sx, sy))
+                {
+                    continue;
+                }
+
+                int s = mesh.toIndex(sx, sy);
+                int cost = addCost(g[u], mesh.stepCost(s, u));
+                if (s != goal && cost < rhs[s])
+                {
+                    rhs[s] = cost;
+                    if (g[s] != rhs[s])
+                        open.push(s, calcKey(mesh, s));
+                    else
+                        open.remove(s);
+                }
+            }
+        }
+        else
+        {
+            int old_g = g[u];
+            g[u] = INT_MAX;
+            updateNode(mesh, u);
+            for (int i = 0; i < 8; i++)
+            {
+                int sx = ux + NEIGHBOR_DX[i];
+                int sy = uy + NEIGHBOR_DY[i];
+                if (!mesh.inBounds(sx, sy))
+                {
+                    continue;
+                }
+
+                int s = mesh.toIndex(sx, sy);
+                if (s != goal && rhs[s] == addCost(old_g, mesh.stepCost(s, u)))
+                {
+                    updateNode(mesh, s);
+                }
+            }
+        }
+    }
+}
+
+// Cheapest cost to goal through one of node's neighbors. The neighbor is
+// written to best_next if it isn't NULL.
+int PathPlanner::lookahead(const Mesh &mesh, int node, int *best_next) const
+{
+    int x = node % mesh.length;
+    int y = node / mesh.length;
+    int best = INT_MAX;
+
+    for (int i = 0; i < 8; i++)
+    {
+        int nx = x + NEIGHBOR_DX[i];
+        int ny = y + NEIGHBOR_DY[i];
+        if (!mesh.inBounds(nx, ny))
+        {
+            continue;
+        }
+
+        int n = mesh.toIndex(nx, ny);
+        int cost = addCost(g[n], mesh.stepCost(node, n));
+        if (cost < best)
+        {
+            best = cost;
+            if (best_next)
+            {
+                *best_next = n;
+            }
+        }
+    }
+
+    return best;
+}
+
+PathPlanner::Key PathPlanner::calcKey(const Mesh &mesh, int node) const
+{
+    int cost = std::min(g[node], rhs[node]);
+    return Key(addCost(addCost(cost, mesh.heuristic(start, node)), km), cost);
+}
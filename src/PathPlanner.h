@@ -0,0 +1,63 @@
+#pragma once
+#include "FrameArena.h"
+#include "PathHeap.h"
+#include <utility>
+#include <vector>
+
+class Mesh;
+
+/***************************************************************************//**
+PathPlanner keeps the search state of one agent between calls to
+Mesh::calcPath, and repairs it with D* Lite instead of searching from scratch
+every time.\n
+The search runs backwards from the target, so each node knows the cost of its
+cheapest path to the target. When the agent moves, only the heuristic shifts
+and most of that knowledge stays valid. When objects are inserted or cleared,
+the planner reads the nodes that changed from the mesh's change log and only
+re-examines the search tree around them, so a door closing across the level
+costs a handful of expansions instead of a full search.\n
+Costs are the same as the A_STAR mode of Mesh::calcPath. Changing target, or
+falling so far behind the mesh that its change log no longer reaches back to
+the planner's last search, starts the search over.\n
+PathPlanner only stores plain data; every method is handed the mesh it plans
+on. Give each agent its own planner.
+*******************************************************************************/
+class PathPlanner
+{
+    public:
+        PathPlanner();
+
+/***************************************************************************//**
+@fn bool findPath(const Mesh &mesh, int start, int goal, frame_vector<int> &nodes)
+Fills nodes with the indices of the nodes on the cheapest path from start to
+goal, goal first and without start. Returns false if no path exists.
+@fn void reset()
+Forgets the search, so the next findPath starts from scratch.
+@fn int getNodesExpanded() const
+Returns how many nodes the last findPath expanded.
+*******************************************************************************/
+        bool findPath(const Mesh &mesh, int start, int goal, frame_vector<int> &nodes);
+        void reset();
+        int getNodesExpanded() const { return expanded; }
+
+    private:
+        typedef std::pair<int, int> Key;
+
+        void initialize(const Mesh &mesh, int start, int goal);
+        void applyChanges(const Mesh &mesh);
+        void updateNode(const Mesh &mesh, int node);
+        void computePath(const Mesh &mesh);
+        int lookahead(const Mesh &mesh, int node, int *best_next) const;
+        Key calcKey(const Mesh &mesh, int node) const;
+
+        int start, goal;
+        int last_start;        // Start when km was last adjusted
+        int km;                // Total heuristic drift since the search began
+        unsigned version;      // Mesh version the search is up to date with
+        int num_nodes;
+        int expanded;
+
+        std::vector<int> g;   // Cost to goal as of the last expansion
+        std::vector<int> rhs; // One-step lookahead cost to goal
+        PathHeap<Key> open;   // Inconsistent nodes, where g != rhs
+};
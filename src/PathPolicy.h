@@ -0,0 +1,164 @@
+#pragma once
+#include "Mesh.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+/***************************************************************************//**
+A PathPolicy decides what each step of a Mesh::calcPath search costs and how
+far from the target a node is estimated to be. Policies are plain classes
+passed by type, so the search is compiled once per policy with its costs
+inlined.\n
+To write your own, derive from PathPolicy and hide either method:
+- stepCost(mesh, from, to, step) returns the cost of moving from node from to
+  the adjacent node to. step is the default cost: STRAIGHT_COST or
+  DIAGONAL_COST, plus BLOCKED_COST if the move enters or cuts the corner of an
+  object. Costs must be positive.
+- heuristic(mesh, from, to) must never be more than the true cost of the
+  cheapest path between the two nodes, or paths may not be the cheapest.
+\verbatim
+// Lets the AI walk over healing potions without a second thought
+struct IgnorePotions : public PathPolicy
+{
+    int stepCost(const Mesh &mesh, int from, int to, int step) const
+    {
+        return is_potion[to] ? step - Mesh::BLOCKED_COST : step;
+    }
+};
+\endverbatim
+*******************************************************************************/
+struct PathPolicy
+{
+    int stepCost(const Mesh &, int, int, int step) const { return step; }
+    int heuristic(const Mesh &mesh, int from, int to) const { return mesh.heuristic(from, to); }
+};
+
+/***************************************************************************//**
+AvoidObjects is the policy Mesh::calcPath uses by default: every free node
+costs the same and objects are walked around unless there's no other way.
+*******************************************************************************/
+struct AvoidObjects : public PathPolicy
+{
+};
+
+/***************************************************************************//**
+WeightedTerrain scales the cost of entering each node by a weight, in percent:
+100 is normal ground, 300 is mud that costs three times as much to cross, 50 is
+a road. weights holds one entry per node, indexed like Mesh::getNodeIndex, and
+must outlive the policy. The heuristic prices each step at the smallest weight,
+rounded down like stepCost rounds it, so it never overestimates.
+*******************************************************************************/
+class WeightedTerrain : public PathPolicy
+{
+    public:
+        WeightedTerrain(const std::vector<int> &weights)
+        {
+            this->weights = &weights;
+            int min_weight = weights.empty() ? 100 : *std::min_element(weights.begin(), weights.end());
+            straight_cost = std::max(Mesh::STRAIGHT_COST * min_weight / 100, 1);
+            diagonal_cost = std::max(Mesh::DIAGONAL_COST * min_weight / 100, 1);
+        }
+
+        int stepCost(const Mesh &, int, int to, int step) const
+        {
+            int penalty = step >= Mesh::BLOCKED_COST ? Mesh::BLOCKED_COST : 0;
+            return std::max((step - penalty) * (*weights)[to] / 100, 1) + penalty;
+        }
+
+        int heuristic(const Mesh &mesh, int from, int to) const
+        {
+            int length = mesh.getLength();
+            int dx = std::abs(from % length - to % length);
+            int dy = std::abs(from / length - to / length);
+            int diagonal = std::min(dx, dy);
+            return diagonal_cost * diagonal + straight_cost * (std::max(dx, dy) - diagonal);
+        }
+
+    private:
+        const std::vector<int> *weights;
+        int straight_cost, diagonal_cost; // Cheapest step of each kind
+};
+
+/***************************************************************************//**
+PreferCover makes agents hug walls. Nodes with no object on any side of them
+are exposed, and entering one costs exposed_cost percent more than normal, so
+a path will take a somewhat longer route to stay next to cover.
+*******************************************************************************/
+class PreferCover : public PathPolicy
+{
+    public:
+        PreferCover(int exposed_cost = 50)
+        {
+            this->exposed_cost = exposed_cost;
+        }
+
+        int stepCost(const Mesh &mesh, int, int to, int step) const
+        {
+            if (isExposed(mesh, to))
+            {
+                int penalty = step >= Mesh::BLOCKED_COST ? Mesh::BLOCKED_COST : 0;
+                step += (step - penalty) * exposed_cost / 100;
+            }
+            return step;
+        }
+
+    private:
+        bool isExposed(const Mesh &mesh, int node) const
+        {
+            int length = mesh.getLength();
+            int x = node % length;
+            int y = node / length;
+            for (int j = std::max(y - 1, 0); j <= std::min(y + 1, mesh.getThickness() - 1); j++)
+            {
+                for (int i = std::max(x - 1, 0); i <= std::min(x + 1, length - 1); i++)
+                {
+                    if (mesh.isBlocked(j * length + i))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        int exposed_cost;
+};
+
+/***************************************************************************//**
+KeepClearance routes an agent wider than one node. Entering a node with less
+than clearance steps between it and the nearest object, or cutting diagonally
+past one, costs as much as entering an object, so the path only squeezes
+through a gap too narrow for the agent when there's no way around.
+Mesh::buildClearance must have been called. Mesh::calcPath uses it by itself
+when PathOptions::radius is set.
+*******************************************************************************/
+class KeepClearance : public PathPolicy
+{
+    public:
+        KeepClearance(int clearance)
+        {
+            this->clearance = clearance;
+        }
+
+        int stepCost(const Mesh &mesh, int from, int to, int step) const
+        {
+            if (step >= Mesh::BLOCKED_COST)
+            {
+                return step;
+            }
+
+            // Diagonal steps sweep past both corners, as with objects
+            int length = mesh.getLength();
+            bool diagonal = from % length != to % length && from / length != to / length;
+            if (mesh.getClearance(to) < clearance
+                || (diagonal && (mesh.getClearance(from / length * length + to % length) < clearance
+                                 || mesh.getClearance(to / length * length + from % length) < clearance)))
+            {
+                step += Mesh::BLOCKED_COST;
+            }
+            return step;
+        }
+
+    private:
+        int clearance;
+};
@@ -0,0 +1,195 @@
+#include "PathQueue.h"
+#include <chrono>
+using std::vector;
+using std::pair;
+
+PathQueue::PathQueue(int num_threads)
+{
+    stopping = false;
+    source = NULL;
+    source_version = 0;
+    next_ticket = 0;
+
+    for (int i = 0; i < num_threads; i++)
+    {
+        workers.push_back(std::thread(&PathQueue::work, this));
+    }
+}
+
+PathQueue::~PathQueue()
+{
+    mtx.lock();
+    stopping = true;
+    requests.clear();
+    mtx.unlock();
+    wake.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+}
+
+int PathQueue::submit(Vector3 start, Vector3 target, PathOptions options)
+{
+    Request request;
+    request.start = start;
+    request.target = target;
+    request.options = options;
+
+    mtx.lock();
+    request.ticket = next_ticket++;
+    requests.push_back(request);
+    mtx.unlock();
+    wake.notify_one();
+
+    return request.ticket;
+}
+
+bool PathQueue::poll(int ticket, vector<Vector3> &path)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto found = results.find(ticket);
+    if (found == results.end())
+    {
+        return false;
+    }
+
+    path.swap(found->second);
+    results.erase(found);
+    return true;
+}
+
+void PathQueue::cancel(int ticket)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto it = requests.begin(); it != requests.end(); ++it)
+    {
+        if (it->ticket == ticket)
+        {
+            requests.erase(it);
+            return;
+        }
+    }
+
+    if (running.count(ticket))
+    {
+        cancelled.insert(ticket);
+    }
+    results.erase(ticket);
+}
+
+/*******************************************************************************
+Taking a snapshot is the only work the game thread always does here, and only
+when the mesh changed. It is copied outside the lock so workers keep searching
+the old one meanwhile. Snapshots alternate between two meshes: the spare is
+only written once no search holds it, which use_count tells reliably under the
+lock, since searches only take the newest snapshot and let go of it with the
+lock held. Otherwise a new one is made and the busy spare is dropped once its
+searches finish.
+*******************************************************************************/
+void PathQueue::update(const Mesh &mesh, double budget)
+{
+    if (!snapshot || source != &mesh || source_version != mesh.getVersion())
+    {
+        std::shared_ptr<Mesh> copy;
+        mtx.lock();
+        if (spare.use_count() == 1)
+        {
+            copy.swap(spare);
+        }
+        mtx.unlock();
+        if (!copy)
+        {
+            copy.reset(new Mesh());
+        }
+        copy->copySearchData(mesh);
+
+        mtx.lock();
+        spare.swap(snapshot);
+        snapshot.swap(copy);
+        source = &mesh;
+        source_version = mesh.getVersion();
+        mtx.unlock();
+        wake.notify_all();
+    }
+
+    if (workers.empty())
+    {
+        auto start = std::chrono::steady_clock::now();
+        while (runNext(space, false))
+        {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (elapsed.count() >= budget)
+            {
+                break;
+            }
+        }
+    }
+}
+
+int PathQueue::getPending() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return requests.size() + running.size();
+}
+
+/*******************************************************************************
+Takes the oldest request and searches the newest snapshot for it. If wait is
+set, blocks until there is a request to run; returns false once the queue is
+stopping. Otherwise returns false straight away if there's nothing to run.
+*******************************************************************************/
+bool PathQueue::runNext(SearchSpace &space, bool wait)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (wait && !stopping && (requests.empty() || !snapshot))
+    {
+        wake.wait(lock);
+    }
+    if (stopping || requests.empty() || !snapshot)
+    {
+        return false;
+    }
+
+    Request request = requests.front();
+    requests.pop_front();
+    std::shared_ptr<const Mesh> mesh = snapshot;
+    running.insert(request.ticket);
+    lock.unlock();
+
+    vector<Vector3> path;
+    pair<int, int> start = mesh->getIndicesFromPos(request.start);
+    pair<int, int> target = mesh->getIndicesFromPos(request.target);
+    if (mesh->inBounds(start.first, start.second) && mesh->inBounds(target.first, target.second))
+    {
+        PathOptions options = request.options;
+        if (options.mode == HIERARCHICAL)
+        {
+            options.mode = JUMP_POINT;
+        }
+        int start_index = mesh->toIndex(start.first, start.second);
+        int goal = mesh->resolveGoal(start_index, mesh->toIndex(target.first, target.second), options);
+        if (goal >= 0 && mesh->findPath(space, start_index, goal, options, path) && options.any_angle)
+        {
+            mesh->smoothPath(start_index, path, mesh->getRequiredClearance(options.radius));
+        }
+    }
+
+    lock.lock();
+    mesh.reset();
+    running.erase(request.ticket);
+    if (!cancelled.erase(request.ticket))
+    {
+        results[request.ticket].swap(path);
+    }
+    return true;
+}
+
+// Worker thread body; each worker has its own search arrays
+void PathQueue::work()
+{
+    SearchSpace space;
+    while (runNext(space, true))
+    {
+    }
+}
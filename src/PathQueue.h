@@ -0,0 +1,108 @@
+#pragma once
+#include "Mesh.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/***************************************************************************//**
+PathQueue runs Mesh::calcPath queries in the background so that many agents
+replanning on the same tick don't all land on one frame. An agent submits its
+query and gets a ticket back, then polls the ticket on later ticks until the
+path is ready.\n
+Searches never touch the live mesh. PathQueue::update, called once per tick on
+the game thread, takes a snapshot of the mesh whenever objects were inserted or
+cleared, and each search runs on the newest snapshot there was when it started.
+A snapshot holds only what searches read: the occupancy bits, component labels
+and clearance. It is only ever read, so any number of searches can share it,
+and the previous one is reused for the next snapshot once no search holds it,
+so taking one doesn't allocate.\n
+With worker threads, searches run on them and the game thread only pays for
+the snapshots. With no worker threads, PathQueue::update runs queued searches
+itself until a per-tick time budget is spent, so the frame time stays flat no
+matter how many agents ask at once.\n
+Only the A_STAR and JUMP_POINT search modes are run; HIERARCHICAL queries are
+searched with JUMP_POINT, which walks the same nodes. Results don't go through
+the mesh's path cache. PathOptions::unreachable is only honored once
+Mesh::buildComponents has been called on the mesh, and PathOptions::radius once
+Mesh::buildClearance has.
+\verbatim
+if (ticket < 0)
+    ticket = queue.submit(elf->getPos(), hero->getPos());
+if (queue.poll(ticket, path))
+    ticket = -1;
+\endverbatim
+*******************************************************************************/
+class PathQueue
+{
+    public:
+/***************************************************************************//**
+@fn PathQueue(int num_threads)
+Creates a queue with num_threads worker threads. With 0, searches are run by
+PathQueue::update on the calling thread.
+@fn ~PathQueue()
+Drops any queued searches and waits for the workers to finish their current
+one.
+*******************************************************************************/
+        PathQueue(int num_threads = 1);
+        ~PathQueue();
+
+/***************************************************************************//**
+@fn int submit(Vector3 start, Vector3 target, PathOptions options)
+Queues a search from start to target and returns its ticket.
+@fn bool poll(int ticket, std::vector<Vector3> &path)
+If the search for ticket has finished, moves its path into path (in the same
+form as Mesh::calcPath), forgets the ticket and returns true. Returns false
+while the search is still queued or running.
+@fn void cancel(int ticket)
+Forgets ticket. Its search is skipped if it hasn't started yet.
+*******************************************************************************/
+        int submit(Vector3 start, Vector3 target, PathOptions options = PathOptions());
+        bool poll(int ticket, std::vector<Vector3> &path);
+        void cancel(int ticket);
+
+/***************************************************************************//**
+@fn void update(const Mesh &mesh, double budget)
+Call once per tick from the game thread. Takes a new snapshot of mesh if it
+changed since the last one. Without worker threads, also runs queued searches until
+budget seconds have passed, always finishing at least one.
+@fn int getPending() const
+Returns the number of searches queued or running.
+*******************************************************************************/
+        void update(const Mesh &mesh, double budget = 0.002);
+        int getPending() const;
+
+    private:
+        PathQueue(const PathQueue &);
+        PathQueue &operator=(const PathQueue &);
+
+        struct Request {
+            int ticket;
+            Vector3 start, target;
+            PathOptions options;
+        };
+
+        bool runNext(SearchSpace &space, bool wait);
+        void work();
+
+        std::vector<std::thread> workers;
+        mutable std::mutex mtx;
+        std::condition_variable wake;
+        bool stopping;
+
+        std::shared_ptr<Mesh> snapshot;
+        std::shared_ptr<Mesh> spare; // The snapshot before, reused once unused
+        const Mesh *source;       // Mesh the snapshot was copied from
+        unsigned source_version;  // Its version at the time
+
+        int next_ticket;
+        std::unordered_set<int> running;   // Tickets being searched right now
+        std::unordered_set<int> cancelled; // Of those, the ones cancelled since
+        std::deque<Request> requests;
+        std::unordered_map<int, std::vector<Vector3> > results;
+        SearchSpace space; // For searches run by update
+};
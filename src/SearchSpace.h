@@ -0,0 +1,66 @@
+#pragma once
+#include "PathHeap.h"
+#include <utility>
+#include <vector>
+
+/***************************************************************************//**
+SearchSpace holds the per-node scratch arrays of a ::Mesh search. Nodes are
+identified by their index in the mesh (y * length + x), so the g scores and
+parents are flat arrays rather than per-node objects. They are interleaved
+into one SearchNode per node so that looking at a neighbor touches a single
+cache line.\n
+Every entry is stamped with the generation of the search that wrote it. A new
+search bumps the generation instead of clearing the arrays, so entries left
+over from earlier searches are simply ignored.
+*******************************************************************************/
+struct SearchNode {
+    int g;           // Cost of the best known path to this node
+    int parent;      // Node this node was reached from
+    unsigned seen;   // Generation in which g and parent were set
+    unsigned closed; // Generation in which the node was expanded
+};
+
+struct SearchSpace {
+    std::vector<SearchNode> nodes;
+    PathHeap<std::pair<int, int> > open; // Keyed by (f, h)
+    unsigned generation;
+    int expanded;
+
+    SearchSpace()
+    {
+        generation = 0;
+        expanded = 0;
+    }
+
+/***************************************************************************//**
+@fn void begin(int num_nodes)
+Prepares the arrays for a new search over num_nodes nodes. They are resized
+when the number of nodes has changed, then a new generation is started so
+everything written by earlier searches is ignored.
+*******************************************************************************/
+    void begin(int num_nodes)
+    {
+        if ((int)nodes.size() != num_nodes)
+        {
+            SearchNode blank = { 0, -1, 0, 0 };
+            nodes.assign(num_nodes, blank);
+            open.resize(num_nodes);
+            generation = 0;
+        }
+        else
+        {
+            open.clear();
+        }
+
+        if (++generation == 0)
+        {
+            for (size_t i = 0; i < nodes.size(); i++)
+            {
+                nodes[i].seen = 0;
+                nodes[i].closed = 0;
+            }
+            generation = 1;
+        }
+        expanded = 0;
+    }
+};
@@ -22,10 +22,11 @@ TitleMenu::TitleMenu()
     auto font = find_font("times48");
 
     // Create the menu
-    Button *new_game = new Button(NULL, NULL, "New Game", find_font("times", 32),  BLUE, RED, WIDTH / 2 - 125, HEIGHT / 2 - 64, begin_game);
-    Button *load_game = new Button(NULL, NULL, "Load Game", find_font("times", 32),BLUE, RED, WIDTH / 2 + 125, HEIGHT / 2 - 64, do_nothing);
-    Button *options = new Button(NULL, NULL, "Options", find_font("times", 32),    BLUE, RED, WIDTH / 2, HEIGHT / 2, do_nothing);
-    Button *controls = new Button(NULL, NULL, "Controls", find_font("times", 32),  BLUE, RED, WIDTH / 2, HEIGHT / 2 + 64, do_nothing);
+    asset_handle times32 = font_handle(asset_id("times"), 32);
+    Button *new_game = new Button(NULL, NULL, "New Game", find_font(times32),  BLUE, RED, WIDTH / 2 - 125, HEIGHT / 2 - 64, begin_game);
+    Button *load_game = new Button(NULL, NULL, "Load Game", find_font(times32),BLUE, RED, WIDTH / 2 + 125, HEIGHT / 2 - 64, do_nothing);
+    Button *options = new Button(NULL, NULL, "Options", find_font(times32),    BLUE, RED, WIDTH / 2, HEIGHT / 2, do_nothing);
+    Button *controls = new Button(NULL, NULL, "Controls", find_font(times32),  BLUE, RED, WIDTH / 2, HEIGHT / 2 + 64, do_nothing);
 
     main_menu.addButton("new_game", new_game, "", "options", "", "load_game");
     main_menu.addButton("load_game", load_game, "", "options", "new_game", "");
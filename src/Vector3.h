@@ -1,3 +1,4 @@
+#pragma once
 /***************************************************************************//**
 A Vector3 is a mathematical vector with 3 components: x, y, and z.
 This struct also has methods to add two Vector3's, compute the cross product,
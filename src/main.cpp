@@ -76,6 +76,7 @@ int main()
 
     printf("Loading assets\n");
     load_bitmaps();
+    pack_urgent_bitmaps();
     load_fonts();
     load_samples();
 